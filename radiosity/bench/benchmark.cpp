@@ -0,0 +1,312 @@
+/*
+Radiosity Benchmark
+Times the hot paths of the solver and the renderers over a sweep of hps and HemiCube resolutions:
+Quad::hit, Element::get_ray, Element::calc_ff, Quad_manager::calc_ff, mult_m (matrix-matrix and
+matrix-vector), num_solver_gs, Face::add_radiosities and the projectors' render.
+
+Every case runs warmup untimed repeats first, then repeats timed ones, and reports min, median and mean
+seconds. Results are printed and written as JSON:
+
+{"threads":T,"warmup":W,"repeats":R,"results":[
+ {"name":"quad_hit","hps":4,"hemicube":50,"n":81,"threads":1,"ops":...,"min_s":...,"median_s":...,"mean_s":...}, ...]}
+
+T is the size of the pool quad_manager_calc_ff and the renders run on (--threads, 0 = every hardware thread), 
+every case records the threads it actually ran on: 1 for the serial kernels, T for the pooled ones.
+Scenes are solved with the Solution_cache off (Space::set_persistence), so every hps pays its full solve and 
+no radiosity_cache.bin or matrix debug PPMs land in the working directory.
+
+ops is the work done by one repeat (rays, quad tests, multiply-adds, ...), so ops / min_s is a throughput.
+Renders need a solved scene and do not depend on the HemiCube, they run once per hps at the first resolution.
+
+usage: benchmark [--hps 2,4,6] [--hemicube 25,50,100] [--threads 0] [--warmup 1] [--repeats 3] [--out benchmark.json]
+ */
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <numeric>
+#include <chrono>
+#include <cfloat>
+#include <cstdlib>
+
+#include "space.h"
+#include "quad_manager.h"
+#include "stimuli.h"
+#include "face.h"
+#include "matrix.h"
+#include "projector.h"
+#include "raster_projector.h"
+#include "camera.h"
+#include "thread_pool.h"
+
+struct Bench_result{
+    std::string name;
+    int hps;
+    int hc;
+    size_t n;
+    size_t threads;
+    size_t ops;
+    double min_s;
+    double median_s;
+    double mean_s;
+};
+
+struct Bench_config{
+    std::vector<int> hps;
+    std::vector<int> hc;
+    int threads;
+    int warmup;
+    int repeats;
+    std::string out;
+};
+
+static const float fw = 10.0f;
+
+/*
+Sink for benchmark results, keeps the optimizer from dropping the work.
+ */
+static volatile float sink;
+
+/*
+static Bench_result run_case(...)
+Description:
+Runs f warmup times untimed and repeats times timed.
+
+Parameters:
+const std::string& name: Case name.
+int hps: Elements per face side.
+int hc: HemiCube resolution.
+size_t n: Element count.
+size_t tc: Threads f runs on.
+size_t ops: Work done by one call of f.
+const Bench_config& cfg: Warmup and repeat counts.
+const F& f: Case body.
+
+Output:
+Bench_result: Timings in seconds.
+ */
+template<typename F>
+static Bench_result run_case(const std::string& name, int hps, int hc, size_t n, size_t tc, size_t ops, const Bench_config& cfg, const F& f)
+{
+    for(int i = 0; i < cfg.warmup; ++i) f();
+    std::vector<double> t(cfg.repeats);
+    for(int i = 0; i < cfg.repeats; ++i){
+        auto t0 = std::chrono::steady_clock::now();
+        f();
+        t[i] = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    }
+    std::sort(t.begin(), t.end());
+    double median = t.size() % 2 ? t[t.size()/2] : 0.5*(t[t.size()/2 - 1] + t[t.size()/2]);
+    double mean = std::accumulate(t.begin(), t.end(), 0.0) / double(t.size());
+    Bench_result r{name, hps, hc, n, tc, ops, t.front(), median, mean};
+    std::cout << name << " hps " << hps << " hemicube " << hc << " threads " << tc << ": min " << r.min_s
+        << " s, median " << r.median_s << " s, mean " << r.mean_s << " s" << std::endl;
+    return r;
+}
+
+/*
+static void bench_solver(int hps, int hc, Thread_pool& pool, const Bench_config& cfg, std::vector<Bench_result>& res)
+Description:
+Geometry, Form-Factor and solver cases for one hps and HemiCube resolution, 
+Quad_manager::calc_ff runs on pool, the other kernels are serial.
+
+Parameters:
+int hps: Elements per face side.
+int hc: HemiCube resolution.
+Thread_pool& pool: Pool of the Form-Factor rows.
+const Bench_config& cfg: Warmup and repeat counts.
+std::vector<Bench_result>& res: Results are appended here.
+
+Output: -
+ */
+static void bench_solver(int hps, int hc, Thread_pool& pool, const Bench_config& cfg, std::vector<Bench_result>& res)
+{
+    size_t tc = pool.get_thread_count();
+    Quad_manager qm{fw, hps};
+    qm.set_hemicube(hc, hc);
+    size_t n = qm.get_count();
+    const std::vector<std::shared_ptr<Quad>>& quads = qm.get_quads();
+
+    // NOTE(Alex): Hemicube rays of the first floor element, with the element each one hits
+    Quad& e = *quads[0];
+    std::vector<Ray> rays;
+    std::vector<Element_ref> hits;
+    std::vector<Ray> hit_rays;
+    e.reset_hemicube(hc, hc);
+    for(Ray r{}; e.get_ray(r);){
+        rays.push_back(r);
+        HitRec rec;
+        Quad* q = qm.closest_hit(r, 0.001f, FLT_MAX, rec);
+        if(!q) continue;
+        Element_ref j{};
+        j = *q;
+        hits.push_back(j);
+        hit_rays.push_back(r);
+    }
+
+    res.push_back(run_case("quad_hit", hps, hc, n, 1, rays.size()*quads.size(), cfg, [&]{
+        size_t h = 0;
+        for(const Ray& r : rays){
+            for(auto& q : quads){
+                Ray x = r;
+                HitRec rec;
+                h += q->hit(x, 0.001f, FLT_MAX, rec);
+            }
+        }
+        sink = float(h);
+    }));
+
+    res.push_back(run_case("element_get_ray", hps, hc, n, 1, rays.size(), cfg, [&]{
+        e.reset_hemicube(hc, hc);
+        float s = 0.0f;
+        for(Ray r{}; e.get_ray(r);) s += dot(r.get_direction(), r.get_direction());
+        sink = s;
+    }));
+
+    Matrix<float,2> ff(n, n);
+    res.push_back(run_case("element_calc_ff", hps, hc, n, 1, hit_rays.size(), cfg, [&]{
+        for(size_t k = 0; k < hit_rays.size(); ++k) e.calc_ff(hit_rays[k], hits[k], ff);
+    }));
+
+    res.push_back(run_case("quad_manager_calc_ff", hps, hc, n, tc, rays.size()*n, cfg, [&]{
+        qm.calc_ff(ff, nullptr, &pool);
+    }));
+
+    Matrix<float,2> f(n, n);
+    qm.calc_ff(f, nullptr, &pool);
+    Stimuli s{n};
+    s.set_stimuli(5, hps, 15.0f, 0.73f, 0.12f, 0.73f, 0.65f, 0.73f);
+    s.build_k(f);
+    Matrix<float,1> b(n);
+    for(size_t i = 0; i < n; ++i) b(i) = 1.0f;
+
+    res.push_back(run_case("mult_m_mm", hps, hc, n, 1, n*n*n, cfg, [&]{
+        Matrix<float,2> m = mult_m(f, f);
+        sink = m(0, 0);
+    }));
+
+    res.push_back(run_case("mult_m_mv", hps, hc, n, 1, n*n, cfg, [&]{
+        Matrix<float,1> m = mult_m(f, b);
+        sink = m(0);
+    }));
+
+    res.push_back(run_case("num_solver_gs", hps, hc, n, 1, n*n, cfg, [&]{
+        Matrix<float,1> x(n);
+        num_solver_gs(s.k, x, s.e);
+        sink = x(0);
+    }));
+
+    std::vector<std::shared_ptr<Quad>> fq;
+    ElemIndex ei = 0;
+    Face_xy_z0 face{fw, hps, ei, fq};
+    res.push_back(run_case("face_add_radiosities", hps, hc, n, 1, fq.size(), cfg, [&]{
+        face.add_radiosities(s.e, s.e, s.e);
+    }));
+}
+
+/*
+static void bench_render(int hps, int hc, const Bench_config& cfg, std::vector<Bench_result>& res)
+Description:
+Render cases on a solved scene: ray cast ortho + perspective views and the rasterizer, 
+both on cfg.threads threads.
+
+Parameters:
+int hps: Elements per face side.
+int hc: HemiCube resolution used to solve.
+const Bench_config& cfg: Warmup and repeat counts.
+std::vector<Bench_result>& res: Results are appended here.
+
+Output: -
+ */
+static void bench_render(int hps, int hc, const Bench_config& cfg, std::vector<Bench_result>& res)
+{
+    const int side = 256;
+    Space space{fw, hps};
+    space.set_persistence(false);
+    space.set_threads(size_t(cfg.threads));
+    space.set_hemicube(hc, hc);
+    if(!space.solve()) return;
+    size_t n = space.request_quads().size();
+
+    std::vector<Camera> cams = get_ortho_cameras(fw, fw);
+    cams.push_back(get_persp_camera(fw, fw));
+    for(Camera& c : cams) c.name = "bench_" + c.name;
+    Projector p{size_t(cfg.threads)};
+    res.push_back(run_case("render_raycast", hps, hc, n, p.get_thread_count(), cams.size()*side*side, cfg, [&]{
+        p.render_cameras(space, cams, side, side);
+    }));
+
+    RasterProjector rp{size_t(cfg.threads)};
+    res.push_back(run_case("render_raster", hps, hc, n, rp.get_thread_count(), cams.size()*side*side, cfg, [&]{
+        for(const Camera& c : cams) rp.render(space, c, c.name + "_raster", side, side);
+    }));
+}
+
+static std::vector<int> parse_list(const std::string& s)
+{
+    std::vector<int> l;
+    std::stringstream ss{s};
+    for(std::string x; std::getline(ss, x, ',');) l.push_back(std::atoi(x.c_str()));
+    return l;
+}
+
+static bool write_json(const Bench_config& cfg, size_t tc, const std::vector<Bench_result>& res)
+{
+    std::ofstream o{cfg.out};
+    if(!o) return false;
+    o << "{\"threads\":" << tc
+        << ",\"warmup\":" << cfg.warmup << ",\"repeats\":" << cfg.repeats << ",\"results\":[\n";
+    for(size_t i = 0; i < res.size(); ++i){
+        const Bench_result& r = res[i];
+        o << " {\"name\":\"" << r.name << "\",\"hps\":" << r.hps << ",\"hemicube\":" << r.hc
+            << ",\"n\":" << r.n << ",\"threads\":" << r.threads << ",\"ops\":" << r.ops << ",\"min_s\":" << r.min_s
+            << ",\"median_s\":" << r.median_s << ",\"mean_s\":" << r.mean_s << "}"
+            << (i + 1 < res.size() ? ",\n" : "\n");
+    }
+    o << "]}\n";
+    return bool(o);
+}
+
+int main(int argc, char** argv)
+{
+    Bench_config cfg{{2,4,6}, {25,50,100}, 0, 1, 3, "benchmark.json"};
+    for(int i = 1; i < argc; ++i){
+        std::string a{argv[i]};
+        bool has_value = i + 1 < argc;
+        if(a == "--hps" && has_value) cfg.hps = parse_list(argv[++i]);
+        else if(a == "--hemicube" && has_value) cfg.hc = parse_list(argv[++i]);
+        else if(a == "--threads" && has_value) cfg.threads = std::atoi(argv[++i]);
+        else if(a == "--warmup" && has_value) cfg.warmup = std::atoi(argv[++i]);
+        else if(a == "--repeats" && has_value) cfg.repeats = std::atoi(argv[++i]);
+        else if(a == "--out" && has_value) cfg.out = argv[++i];
+        else
+        {
+            std::cout << "usage: benchmark [--hps 2,4,6] [--hemicube 25,50,100] [--threads 0] [--warmup 1] [--repeats 3] [--out benchmark.json]" << std::endl;
+            return 1;
+        }
+    }
+    bool valid = !cfg.hps.empty() && !cfg.hc.empty() && cfg.threads >= 0 && cfg.warmup >= 0 && cfg.repeats > 0;
+    for(int h : cfg.hps) valid = valid && h > 0;
+    for(int h : cfg.hc) valid = valid && h > 1;
+    if(!valid)
+    {
+        std::cout << "hps and hemicube lists must be positive, threads not negative, repeats at least 1" << std::endl;
+        return 1;
+    }
+
+    Thread_pool pool{size_t(cfg.threads)};
+    std::vector<Bench_result> res;
+    for(int hps : cfg.hps){
+        for(int hc : cfg.hc) bench_solver(hps, hc, pool, cfg, res);
+        bench_render(hps, cfg.hc.front(), cfg, res);
+    }
+    if(!write_json(cfg, pool.get_thread_count(), res))
+    {
+        std::cout << "Unable to write " << cfg.out << std::endl;
+        return 1;
+    }
+    return 0;
+}
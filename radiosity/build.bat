@@ -4,8 +4,9 @@ SETLOCAL ENABLEDELAYEDEXPANSION
 set prjdir=%CD%
 
 set WarnDis= /wd4201 /wd4239 /wd4100 /wd4189 /wd4127 /wd4150 /wd4996 /wd4700
-set CompDebOpt= /c /nologo /EHsc /Zi /Od /MTd /W4 %WarnDis%    
+set CompDebOpt= /c /nologo /EHsc /Zi /Od /MTd /W4 /D RADIOSITY_INSTRUMENT /D RADIOSITY_TRACE %WarnDis%    
 set CompRelOpt= /D NDEBUG /nologo /EHsc /O2 /MT /W4 %WarnDis%  
+set CompInstOpt= %CompRelOpt% /D RADIOSITY_INSTRUMENT /D RADIOSITY_TRACE
 
 set LinkDebOpt= /NOLOGO /INCREMENTAL:NO /DEBUG:FULL  
 set LinkRelOpt= /NOLOGO /INCREMENTAL:NO  
@@ -21,6 +22,48 @@ LINK /OUT:main.exe %LinkDebOpt% %objs%
 
 popd
 
+echo ***INSTRUMENTED***
+if not exist bin\instrumented mkdir bin\instrumented
+pushd bin\instrumented
+set inst_objs=
+
+REM NOTE(Alex): Release options plus instrumentation and trace, phase times of the debug build are unoptimized
+for %%v in ("%prjdir%\source\*.cpp") do cl /c %CompInstOpt% %%v
+for %%v in ("%prjdir%\bin\instrumented\*.obj") do set inst_objs=!inst_objs! %%v
+
+LINK /OUT:main.exe %LinkRelOpt% %inst_objs%
+
+popd
+
+echo ***BENCHMARK***
+if not exist bin\bench mkdir bin\bench
+pushd bin\bench
+set bench_objs=
+
+REM NOTE(Alex): Timings of a debug build mean nothing, the benchmark builds every source with release options
+for %%v in ("%prjdir%\source\*.cpp" "%prjdir%\bench\*.cpp") do cl /c %CompRelOpt% /I"%prjdir%\source" %%v
+for %%v in ("%prjdir%\bin\bench\*.obj") do if /I not "%%~nv"=="main" set bench_objs=!bench_objs! %%v
+
+LINK /OUT:benchmark.exe %LinkRelOpt% %bench_objs%
+
+popd
+
+echo ***TOOLS***
+if not exist bin\tools\obj mkdir bin\tools\obj
+pushd bin\tools\obj
+set tool_objs=
+
+for %%v in ("%prjdir%\source\*.cpp") do cl /c %CompRelOpt% %%v
+for %%v in ("%prjdir%\bin\tools\obj\*.obj") do if /I not "%%~nv"=="main" set tool_objs=!tool_objs! %%v
+
+popd
+pushd bin\tools
+
+REM NOTE(Alex): Every tools\*.cpp is its own executable, linked against the release objs of the sources but main
+for %%v in ("%prjdir%\tools\*.cpp") do cl %CompRelOpt% /I"%prjdir%\source" %%v /link %LinkRelOpt% %tool_objs%
+
+popd
+
 REM echo ***RELEASE***
 REM pushd ..\..\bin\release
 REM cl %CompRelOpt% /Fo"pathtracer_release" %SourceCodePath%\pathtracer.cpp /link %LinkRelOpt% 
@@ -0,0 +1,163 @@
+#include "camera.h"
+#include <cmath>
+
+/* 
+Ray Camera::get_ray(const Vec3<float>& pc)const
+Description:
+Builds the ray through a World-Space canvas sample.
+
+Parameters: 
+const Vec3<float>& pc: Canvas sample in World-Space.
+
+Output:
+Ray: Ray to cast.
+ */
+Ray Camera::get_ray(const Vec3<float>& pc)const
+{
+    if(type == camera_type::ortho) return Ray{pc-e,e};
+    return Ray{e,pc-e};
+}
+
+/* 
+bool Camera::project(const Vec3<float>& p, Vec3<float>& pc, float& t)const
+Description:
+Inverse of get_ray, finds the canvas point whose ray reaches p and the ray parameter it reaches p at, 
+so depths compare the same way hit records do.
+
+Parameters: 
+const Vec3<float>& p: World-Space point.
+Vec3<float>& pc: Canvas point in World-Space.
+float& t: Ray parameter of p, p = get_ray(pc).origin + t * get_ray(pc).direction.
+
+Output:
+bool: Whether p projects onto the canvas plane (perspective points must lie in front of the eye).
+ */
+bool Camera::project(const Vec3<float>& p, Vec3<float>& pc, float& t)const
+{
+    Vec3<float> N = Cross(X, Y);
+    if(type == camera_type::ortho)
+    {
+        float de = dot(e, N);
+        if(de == 0.0f) return false;
+        float s = dot(p - O, N) / de;
+        pc = p - s*e;
+        t = 1.0f + s;
+        return true;
+    }
+    float dp = dot(O - e, N);
+    if(dp == 0.0f) return false;
+    t = dot(p - e, N) / dp;
+    if(t <= 0.0f) return false;
+    pc = e + (1.0f / t) * (p - e);
+    return true;
+}
+
+/* 
+std::vector<Camera> get_ortho_cameras(float fw, float fh)
+Description:
+The five orthogonal views of the Cornell Box, one per face.
+
+Parameters: 
+float fw: Cornell Box's face width.
+float fh: Cornell Box's face height.
+
+Output:
+std::vector<Camera>: Cameras.
+ */
+std::vector<Camera> get_ortho_cameras(float fw, float fh)
+{
+    float cg = 0.4f;
+    /* 
+    X has to be based from 0,0
+Y as well
+Origin has to be the origin!!!
+     */
+    return
+    {
+        // NOTE(Alex): XY (0,0) (5,5) Z = 0
+        {"XY_Z0", camera_type::ortho, {1,0,0}, {0,1,0}, {0,0,0}, fw, fh, cg, {0,0,-1}},
+        // NOTE(Alex): YZ (0,0) (5,5) X = 0
+        {"YZ_X0", camera_type::ortho, {0,0,-1}, {0,1,0}, {0,0,fw}, fw, fh, cg, {-1,0,0}},
+        // NOTE(Alex): XZ (0,0) (5,5) Y = 0
+        {"XZ_Y0", camera_type::ortho, {0,0,-1}, {-1,0,0}, {fw,0,fw}, fw, fh, cg, {0,-1,0}},
+        // NOTE(Alex): YZ (0,0) (5,5) X = 5.0f
+        {"YZ_X5", camera_type::ortho, {0,0,1}, {0,1,0}, {fw,0,0}, fw, fh, cg, {1,0,0}},
+        // NOTE(Alex): XZ (0,0) (5,5) Y = 5.0f
+        {"XZ_Y5", camera_type::ortho, {0,0,1}, {-1,0,0}, {fw,fw,0}, fw, fh, cg, {0,1,0}},
+    };
+}
+
+/* 
+Camera get_persp_camera(float rfw, float rfh)
+Description:
+Perspective view of the Cornell Box from the front face.
+
+Parameters: 
+float rfw: Cornell Box Width.
+float rfh: Cornell Box Height.
+
+Output:
+Camera: Camera.
+ */
+Camera get_persp_camera(float rfw, float rfh)
+{
+#if 0    
+    float fw=rfw + 0.0f;
+    float fh=rfh + 0.0f;
+    float h_fw=fw*0.5f;
+    float h_fh=fh*0.5f;
+    float h_rfw=rfw*0.5f;
+    float h_rfh=rfh*0.5f;
+    Vec3<float> p{h_rfw,h_rfh,rfw+22.0f};
+    Vec3<float> O{h_rfw-h_fw,h_rfh-h_fh,rfw+2.0f};
+#else
+    float fw=0.2f*rfw;
+    float fh=0.2f*rfh;
+    float h_fw=fw*0.5f;
+    float h_fh=fh*0.5f;
+    float h_rfw=rfw*0.5f;
+    float h_rfh=rfh*0.5f;
+    Vec3<float> p{h_rfw,h_rfh,rfw+12.0f};
+    Vec3<float> O{h_rfw-h_fw,h_rfh-h_fh,rfw+10.0f};
+#endif
+    return {"Radiosity", camera_type::persp, {1,0,0}, {0,1,0}, O, fw, fh, 0.0f, p};
+}
+
+/* 
+std::vector<Camera> get_orbit_cameras(float rfw, float rfh, size_t n, float arc)
+Description:
+Camera path for turntables, n frames of the perspective camera orbiting the Cornell Box center around Y, 
+evenly spread over [-arc/2, arc/2]. Frames are named "Orbit_000", "Orbit_001", ...
+
+Parameters: 
+float rfw: Cornell Box Width.
+float rfh: Cornell Box Height.
+size_t n: Frame count.
+float arc: Orbit angle in radians, small arcs keep the eye in front of the open face.
+
+Output:
+std::vector<Camera>: Cameras.
+ */
+std::vector<Camera> get_orbit_cameras(float rfw, float rfh, size_t n, float arc)
+{
+    Camera c0 = get_persp_camera(rfw, rfh);
+    Vec3<float> C{rfw*0.5f, rfh*0.5f, rfw*0.5f};
+    std::vector<Camera> cams;
+    cams.reserve(n);
+    for(size_t i = 0; i < n; ++i){
+        float a = n > 1 ? arc * (float(i) / float(n - 1) - 0.5f) : 0.0f;
+        float ca = std::cos(a);
+        float sa = std::sin(a);
+        auto rot = [&](const Vec3<float>& v){return Vec3<float>{ca*v.x + sa*v.z, v.y, -sa*v.x + ca*v.z};};
+        
+        std::string id = std::to_string(i);
+        if(id.size() < 3) id.insert(0, 3 - id.size(), '0');
+        Camera c = c0;
+        c.name = "Orbit_" + id;
+        c.X = rot(c0.X);
+        c.O = C + rot(c0.O - C);
+        c.e = C + rot(c0.e - C);
+        cams.push_back(c);
+    }
+    return cams;
+}
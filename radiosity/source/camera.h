@@ -0,0 +1,39 @@
+/* date = October 19th 2026 9:12 pm */
+
+/* 
+struct Camera
+referenced by: class Projector and its derived classes
+A view of the scene: a canvas placed in World-Space plus the way rays leave it. 
+Orthogonal cameras cast rays along e from one unit behind every canvas sample, 
+perspective cameras cast rays from the eye position e through every canvas sample.
+ */
+
+#ifndef CAMERA_H
+#define CAMERA_H
+
+#include <string>
+#include <vector>
+#include "vec3.h"
+#include "ray.h"
+
+enum class camera_type : int {ortho=0,persp=1};
+
+struct Camera{
+    Ray get_ray(const Vec3<float>& pc)const;
+    bool project(const Vec3<float>& p, Vec3<float>& pc, float& t)const;
+    std::string name;
+    camera_type type;
+    Vec3<float> X;
+    Vec3<float> Y;
+    Vec3<float> O;
+    float fw;
+    float fh;
+    float cg;
+    Vec3<float> e;
+};
+
+std::vector<Camera> get_ortho_cameras(float fw, float fh);
+Camera get_persp_camera(float rfw, float rfh);
+std::vector<Camera> get_orbit_cameras(float rfw, float rfh, size_t n, float arc);
+
+#endif //CAMERA_H
@@ -1,4 +1,8 @@
 #include "canvas.h"
+#include <iostream>
+#include <algorithm>
+#include "tone_map.h"
+#include "trace.h"
 
 /* 
 Canvas constructor
@@ -30,28 +34,49 @@ ty{th},
 fw{fw_},
 fh{fh_},
 px{0}, 
-py{th - 1}
+py{th - 1},
+fmt{ppm_format::p6},
+bps{3},
+s0{1},
+sn{0},
+wk{0},
+pixels{},
+fs{},
+radiance{},
+fs_acc{mem_category::framebuffer},
+radiance_acc{mem_category::framebuffer}
 {}
 
 
 /* 
 Canvas::open_ppm_file
 Description:
-Opends a PPM file and stores handle into fs.
+Creates a PPM file, maps it into fs and writes the header. P6 holds exactly the tw x th grid, samples 1..tw*th, 
+P3 keeps a slot for every sample so it stays byte identical to the serial not_finished_writing walk.
 
 Parameters: 
 std::string file_s: FileName.
+ppm_format fmt_: Binary P6 or text P3.
 
 Output:
 bool: Whether fs gets File handle successfully.
  */
-bool Canvas::open_ppm_file(std::string file_s)
+bool Canvas::open_ppm_file(std::string file_s, ppm_format fmt_)
 {
-    fs.open(file_s, std::ios::trunc | std::ios::out);
-    if(fs.is_open()){
-        fs << "P3\n" << tx << " " << ty << "\n255\n";
+    fmt = fmt_;
+    bps = fmt == ppm_format::p6 ? 3 : 12;
+    s0 = fmt == ppm_format::p6 ? 1 : 0;
+    sn = fmt == ppm_format::p6 ? size_t(tx)*size_t(ty) : get_sample_count();
+    wk = 0;
+    std::string h = (fmt == ppm_format::p6 ? "P6\n" : "P3\n") + std::to_string(tx) + " " + std::to_string(ty) + "\n255\n";
+    if(fs.create(file_s, h.size() + sn*bps)){
+        unsigned char* d = static_cast<unsigned char*>(fs.get_data());
+        std::copy(h.begin(), h.end(), d);
+        pixels = d + h.size();
+        fs_acc.set(h.size() + sn*bps);
         return true;
     }
+    std::cout << "Unable to open file:" << file_s << std::endl;
     return false;
 }
 
@@ -90,6 +115,93 @@ Vec3<float> Canvas::get_p_sample()
     return std::get<0>(pxy) + std::get<1>(pxy) + Origin + ShiftX + ShiftY;
 }
 
+/* 
+std::pair<int,int> Canvas::get_sample_pos(size_t k)const
+Description:
+Texture Coordinates of the k-th sample written by the get_p_sample / not_finished_writing walk, 
+so samples can be taken in any order and still be written in the serial order. 
+The walk starts at (0,th-1), then visits columns 1..tw of every row top to bottom, and ends 
+with one last sample at (1,-1): get_sample_count() samples in total.
+
+Parameters: 
+size_t k: Sample index in write order.
+
+Output:
+std::pair<int,int>: Texture Coordinates (u,v).
+ */
+std::pair<int,int> Canvas::get_sample_pos(size_t k)const
+{
+    if(k == 0) return {0, ty - 1};
+    size_t m = k - 1;
+    return
+    {
+        1 + static_cast<int>(m % size_t(tx)),
+        ty - 1 - static_cast<int>(m / size_t(tx)),
+    };
+}
+
+/* 
+Vec3<float> Canvas::get_p_sample(size_t k)const
+Description:
+World space sample of the k-th sample in write order, it does not touch the writing position.
+
+Parameters: 
+size_t k: Sample index in write order.
+
+Output:
+Vec3<float> A world space sample.
+ */
+Vec3<float> Canvas::get_p_sample(size_t k)const
+{
+    auto t = get_sample_pos(k);
+    auto uv = conv_text_to_uv(std::get<0>(t),std::get<1>(t));
+    auto pxy = conv_uv_to_world(uv);
+    return std::get<0>(pxy) + std::get<1>(pxy) + Origin + ShiftX + ShiftY;
+}
+
+/* 
+Vec3<float> Canvas::get_p_sample(size_t k, float du, float dv)const
+Description:
+World space point offset from the k-th sample by a fraction of a pixel, used for subsamples.
+
+Parameters: 
+size_t k: Sample index in write order.
+float du: Offset along the width axis, in pixels.
+float dv: Offset along the height axis, in pixels.
+
+Output:
+Vec3<float> A world space point.
+ */
+Vec3<float> Canvas::get_p_sample(size_t k, float du, float dv)const
+{
+    auto t = get_sample_pos(k);
+    std::pair<float,float> uv
+    {
+        (static_cast<float>(std::get<0>(t)) + du) / static_cast<float>(tx), 
+        (static_cast<float>(std::get<1>(t)) + dv) / static_cast<float>(ty), 
+    };
+    auto pxy = conv_uv_to_world(uv);
+    return std::get<0>(pxy) + std::get<1>(pxy) + Origin + ShiftX + ShiftY;
+}
+
+/* 
+size_t Canvas::get_sample_index(int u, int v)const
+Description:
+Inverse of get_sample_pos for the tw x th image grid, u in [1,tw] and v in [0,th-1].
+
+Parameters: 
+int u: X texture Coordinate.
+int v: Y texture Coordinate.
+
+Output:
+size_t: Sample index in write order, get_sample_count() when (u,v) lies outside the grid.
+ */
+size_t Canvas::get_sample_index(int u, int v)const
+{
+    if(u < 1 || u > tx || v < 0 || v >= ty) return get_sample_count();
+    return 1 + size_t(ty - 1 - v)*size_t(tx) + size_t(u - 1);
+}
+
 /* 
 std::pair<float,float> Canvas::conv_text_to_uv(int u, int v)
 Description:
@@ -102,7 +214,7 @@ int v: Y texture Coordinate.
 Output:
 std::pair<float,float>: a pair Object that returns UV coordinates.
  */
-std::pair<float,float> Canvas::conv_text_to_uv(int u, int v)
+std::pair<float,float> Canvas::conv_text_to_uv(int u, int v)const
 {
     return 
     {
@@ -122,7 +234,7 @@ std::pair<float,float> p: a pair Object with uv coordinates.
 Output:
 std::pair<Vec3<float>,Vec3<float>> a pair Object with World Coordinates.
  */
-std::pair<Vec3<float>,Vec3<float>> Canvas::conv_uv_to_world(std::pair<float,float> p)
+std::pair<Vec3<float>,Vec3<float>> Canvas::conv_uv_to_world(std::pair<float,float> p)const
 {
     return 
     {
@@ -131,10 +243,32 @@ std::pair<Vec3<float>,Vec3<float>> Canvas::conv_uv_to_world(std::pair<float,floa
     };
 }
 
+/* 
+std::pair<float,float> Canvas::conv_world_to_text(const Vec3<float>& p)const
+Description:
+Converts a World-Space point lying on the canvas plane back to (fractional) Texture Coordinates, 
+inverse of get_p_sample.
+
+Parameters: 
+const Vec3<float>& p: World-Space point on the canvas plane.
+
+Output:
+std::pair<float,float>: a pair Object that returns Texture Coordinates.
+ */
+std::pair<float,float> Canvas::conv_world_to_text(const Vec3<float>& p)const
+{
+    Vec3<float> d = p - Origin - ShiftX - ShiftY;
+    return 
+    {
+        dot(d, X) / (fw - cg) * static_cast<float>(tx), 
+        dot(d, Y) / (fh - cg) * static_cast<float>(ty), 
+    };
+}
+
 /* 
 void Canvas::write_color(Color<int>& c)
 Description:
-Writes color into file.
+Writes color at the current writing position, for callers walking the canvas with not_finished_writing.
 
 Parameters: 
 Color<int>& c Tri-stimulus integer based color. Range [0-255]
@@ -143,18 +277,158 @@ Output: -
  */
 void Canvas::write_color(Color<int>& c)
 {
-    fs << c.r << " " << c.g << " " << c.b << std::endl;
+    write_color(wk++, c);
+}
+
+/* 
+static void put_channel(unsigned char* d, int v)
+Description:
+Writes a channel value as 3 right-aligned ASCII digits.
+ */
+static void put_channel(unsigned char* d, int v)
+{
+    d[0] = v >= 100 ? static_cast<unsigned char>('0' + v / 100) : ' ';
+    d[1] = v >= 10 ? static_cast<unsigned char>('0' + (v / 10) % 10) : ' ';
+    d[2] = static_cast<unsigned char>('0' + v % 10);
+}
+
+/* 
+void Canvas::write_color(size_t k, const Color<int>& c)
+Description:
+Writes color of the k-th sample straight into its slot of the mapped file, samples without a slot 
+(the stray first and last ones in P6) are dropped. Distinct samples never share bytes, so tiles may write concurrently.
+
+Parameters: 
+size_t k: Sample index in write order.
+const Color<int>& c Tri-stimulus integer based color, clamped to [0-255].
+
+Output: -
+ */
+void Canvas::write_color(size_t k, const Color<int>& c)
+{
+    if(!pixels || k < s0 || k - s0 >= sn) return;
+    int r = std::min(255, std::max(0, c.r));
+    int g = std::min(255, std::max(0, c.g));
+    int b = std::min(255, std::max(0, c.b));
+    unsigned char* d = pixels + (k - s0)*bps;
+    if(fmt == ppm_format::p6)
+    {
+        d[0] = static_cast<unsigned char>(r);
+        d[1] = static_cast<unsigned char>(g);
+        d[2] = static_cast<unsigned char>(b);
+    }
+    else
+    {
+        put_channel(d, r);
+        d[3] = ' ';
+        put_channel(d + 4, g);
+        d[7] = ' ';
+        put_channel(d + 8, b);
+        d[11] = '\n';
+    }
 }
 
 /* 
 void Canvas::close_ppm_file()
 Description:
-Closes ppm file.
+Closes ppm file, the mapping gets written back by the OS.
 
 Parameters: 
 
 Output: -
  */
 void Canvas::close_ppm_file(){
+    TRACE_SCOPE("close_ppm");
     fs.close();
-}
\ No newline at end of file
+    pixels = nullptr;
+    fs_acc.set(0);
+}
+
+/* 
+void Canvas::allocate_radiance()
+Description:
+Allocates the float RGB buffer, 3 channels per sample in write order, cleared to black.
+
+Parameters: 
+
+Output: -
+ */
+void Canvas::allocate_radiance()
+{
+    radiance.assign(get_sample_count()*3, 0.0f);
+    radiance_acc.set(radiance.size()*sizeof(float));
+}
+
+/* 
+void Canvas::write_radiance(size_t k, const Color<float>& c)
+Description:
+Writes unclipped radiance of the k-th sample into the float buffer. 
+Like write_color, distinct samples never share memory so tiles may write concurrently.
+
+Parameters: 
+size_t k: Sample index in write order.
+const Color<float>& c: Tri-stimulus radiance.
+
+Output: -
+ */
+void Canvas::write_radiance(size_t k, const Color<float>& c)
+{
+    if(k*3 >= radiance.size()) return;
+    float* d = radiance.data() + k*3;
+    d[0] = c.r;
+    d[1] = c.g;
+    d[2] = c.b;
+}
+
+/* 
+bool Canvas::write_pfm(std::string file_s)const
+Description:
+Writes the float buffer as a little-endian color PFM, tw x th samples of the write-order grid. 
+PFM scanlines go bottom to top.
+
+Parameters: 
+std::string file_s: FileName.
+
+Output:
+bool: Whether the file was written.
+ */
+bool Canvas::write_pfm(std::string file_s)const
+{
+    TRACE_SCOPE("write_pfm");
+    if(radiance.empty()) return false;
+    std::ofstream ofs(file_s, std::ios::trunc | std::ios::out | std::ios::binary);
+    if(!ofs.is_open())
+    {
+        std::cout << "Unable to open file:" << file_s << std::endl;
+        return false;
+    }
+    ofs << "PF\n" << tx << " " << ty << "\n-1.0\n";
+    // NOTE(Alex): Sample 1 + r*tw is the left end of the r-th row from the top
+    for(int r = ty - 1; r >= 0; --r){
+        const float* row = radiance.data() + (1 + size_t(r)*size_t(tx))*3;
+        ofs.write(reinterpret_cast<const char*>(row), std::streamsize(size_t(tx)*3*sizeof(float)));
+    }
+    return bool(ofs);
+}
+
+/* 
+bool Canvas::write_tone_mapped(std::string file_s, float exposure)
+Description:
+Tone maps the float buffer straight into a new P6 file, see tone_map.h. 
+Only the tw x th grid of samples 1..tw*th is mapped, the same pixels write_pfm saves.
+
+Parameters: 
+std::string file_s: FileName.
+float exposure: Radiance scale applied before tone mapping.
+
+Output:
+bool: Whether the file was written.
+ */
+bool Canvas::write_tone_mapped(std::string file_s, float exposure)
+{
+    TRACE_SCOPE("write_tone_mapped");
+    if(radiance.empty() || !open_ppm_file(file_s, ppm_format::p6)) return false;
+    tone_map(radiance.data() + 3, pixels, size_t(tx)*size_t(ty)*3, exposure);
+    close_ppm_file();
+    return true;
+}
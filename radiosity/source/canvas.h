@@ -5,6 +5,14 @@ class Canvas
 referenced by: ortho_projector.h
 referenced by: persp_projector.h
 Canvas object works as a space to write color data into a file.
+
+The file is created with its final size and memory-mapped, each sample has a fixed slot at 
+its write-order index, so samples can be written in any order and from any thread. 
+P6 stores 3 bytes per pixel of the tw x th grid (samples 1..tw*th), P3 a fixed-width "rrr ggg bbb\n" 
+text line per sample, stray ones included. Channels are clamped to [0-255].
+
+HDR rendering systems write unclipped radiance into a float RGB buffer instead (allocate_radiance / write_radiance), 
+which is saved as PFM and tone mapped into as many P6 exposures as needed without rendering again.
  */
 
 #ifndef CANVAS_H
@@ -14,19 +22,37 @@ Canvas object works as a space to write color data into a file.
 #include <fstream>
 #include <ios>
 #include <string>
+#include <vector>
 #include "vec3.h"
+#include "mapped_file.h"
+#include "mem_accounting.h"
+
+enum class ppm_format : int {p6=0,p3=1};
 
 class Canvas{
     public:
     Canvas(const Vec3<float>& X_, const Vec3<float>& Y_, const Vec3<float>& O_, const float fw, const float fh, const int th, const int tw, const float cg_ = 0.0f);
     void generate_ray();
-    bool open_ppm_file(std::string);
+    bool open_ppm_file(std::string, ppm_format fmt = ppm_format::p6);
     bool not_finished_writing();
-    std::pair<float,float> conv_text_to_uv(int u, int v);
-    std::pair<Vec3<float>,Vec3<float>> conv_uv_to_world(std::pair<float,float>);
+    std::pair<float,float> conv_text_to_uv(int u, int v)const;
+    std::pair<Vec3<float>,Vec3<float>> conv_uv_to_world(std::pair<float,float>)const;
+    std::pair<float,float> conv_world_to_text(const Vec3<float>& p)const;
     Vec3<float> get_p_sample();
+    size_t get_sample_count()const{return size_t(tx)*size_t(ty) + 2;}
+    std::pair<int,int> get_sample_pos(size_t k)const;
+    Vec3<float> get_p_sample(size_t k)const;
+    Vec3<float> get_p_sample(size_t k, float du, float dv)const;
+    size_t get_sample_index(int u, int v)const;
+    int get_width()const{return tx;}
+    int get_height()const{return ty;}
     void write_color(Color<int>&);
+    void write_color(size_t k, const Color<int>& c);
     void close_ppm_file();
+    void allocate_radiance();
+    void write_radiance(size_t k, const Color<float>& c);
+    bool write_pfm(std::string)const;
+    bool write_tone_mapped(std::string, float exposure);
     private:
     Vec3<float> X;
     Vec3<float> Y;
@@ -40,7 +66,17 @@ class Canvas{
     float fh;
     int px;
     int py;
-    std::ofstream fs;
+    ppm_format fmt;
+    size_t bps;
+    // NOTE(Alex): First sample with a slot in the file and how many slots it holds
+    size_t s0;
+    size_t sn;
+    size_t wk;
+    unsigned char* pixels;
+    Mapped_file fs;
+    std::vector<float> radiance;
+    Mem_account fs_acc;
+    Mem_account radiance_acc;
 };
 
 #endif //CANVAS_H
@@ -0,0 +1,101 @@
+#include "convergence_log.h"
+#include "quad_manager.h"
+#include <iostream>
+
+/*
+ Convergence_log Constructor
+Description:
+Opens path for writing and writes the CSV header, every sweep is reported (cadence 1).
+
+Parameters:
+std::string path_: CSV file.
+std::string mode_: Solver mode written in every record, e.g. f32, q16, q8 or hmat.
+
+Output: -
+ */
+Convergence_log::Convergence_log(std::string path_, std::string mode_):
+Solver_observer{1},
+path{std::move(path_)},
+mode{std::move(mode_)},
+o{path},
+area{},
+t0{}
+{
+    if(!o)
+    {
+        std::cout << "Unable to open " << path << std::endl;
+        return;
+    }
+    o << "mode,sweep,elapsed_s,residual_r,residual_g,residual_b,max_delta_r,max_delta_g,max_delta_b,balance_r,balance_g,balance_b\n";
+}
+
+/*
+void Convergence_log::on_begin(const Quad_manager& qm)
+Description:
+Keeps the area of every element for the energy balance and starts the clock.
+
+Parameters:
+const Quad_manager& qm: Meshed scene about to be solved.
+
+Output: -
+ */
+void Convergence_log::on_begin(const Quad_manager& qm)
+{
+    const std::vector<std::shared_ptr<Quad>>& quads = qm.get_quads();
+    area.assign(quads.size(), 0.0f);
+    for(const std::shared_ptr<Quad>& q : quads){
+        Vec3<float> p = q->get_point(0.0f, 0.0f);
+        area[q->get_index()] = Cross(q->get_point(1.0f, 0.0f) - p, q->get_point(0.0f, 1.0f) - p).norm();
+    }
+    t0 = std::chrono::steady_clock::now();
+}
+
+/*
+void Convergence_log::on_progress(size_t sweep, const Stimuli& r, const Stimuli& g, const Stimuli& b)
+Description:
+Writes the record of one sweep.
+
+Parameters:
+size_t sweep: Sweeps done so far.
+const Stimuli& r: Red stimuli.
+const Stimuli& g: Green stimuli.
+const Stimuli& b: Blue stimuli.
+
+Output: -
+ */
+void Convergence_log::on_progress(size_t sweep, const Stimuli& r, const Stimuli& g, const Stimuli& b)
+{
+    if(!o) return;
+    double t = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    o << mode << ',' << sweep << ',' << t
+        << ',' << r.residual_norm << ',' << g.residual_norm << ',' << b.residual_norm
+        << ',' << r.max_delta << ',' << g.max_delta << ',' << b.max_delta
+        << ',' << balance(r) << ',' << balance(g) << ',' << balance(b) << '\n';
+}
+
+void Convergence_log::on_end()
+{
+    o.flush();
+}
+
+/*
+float Convergence_log::balance(const Stimuli& s)const
+Description:
+Area weighted residual over the emitted power, sum A R / sum A E.
+
+Parameters:
+const Stimuli& s: Stimuli right after a step.
+
+Output:
+float: Unbalanced share of the emitted power.
+ */
+float Convergence_log::balance(const Stimuli& s)const
+{
+    double res = 0.0;
+    double emitted = 0.0;
+    for(size_t i = 0; i < area.size() && i < s.n; ++i){
+        res += double(area[i])*s.residual(i);
+        emitted += double(area[i])*s.e(i);
+    }
+    return emitted > 0.0 ? float(res / emitted) : 0.0f;
+}
@@ -0,0 +1,44 @@
+/* date = October 21st 2026 9:15 am */
+
+/*
+class Convergence_log
+referenced by: main.cpp
+Inherits From: class Solver_observer
+Streams one CSV record per sweep of a solve, so convergence of the solver modes can be compared
+(see tools/convergence_summary.cpp):
+
+mode,sweep,elapsed_s,residual_r,residual_g,residual_b,max_delta_r,max_delta_g,max_delta_b,balance_r,balance_g,balance_b
+
+residual is the squared residual norm the solver checks against its tolerance, max_delta the largest
+change of B in the sweep and balance the area weighted residual over the emitted power, sum A (E + P F B - B) / sum A E:
+the share of the emitted power the current B fails to account for, 0 for an exact solve.
+elapsed_s counts from on_begin. A solution loaded from the Solution_cache is a single record at sweep 0.
+ */
+
+#ifndef CONVERGENCE_LOG_H
+#define CONVERGENCE_LOG_H
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <chrono>
+#include "solver_observer.h"
+
+class Convergence_log : public Solver_observer{
+    public:
+    Convergence_log(std::string path_, std::string mode_);
+    // NOTE(Alex): Solver_observer override
+    void on_begin(const Quad_manager& qm) override;
+    void on_progress(size_t sweep, const Stimuli& r, const Stimuli& g, const Stimuli& b) override;
+    void on_end() override;
+    bool is_open()const{return bool(o);}
+    private:
+    float balance(const Stimuli& s)const;
+    std::string path;
+    std::string mode;
+    std::ofstream o;
+    std::vector<float> area;
+    std::chrono::steady_clock::time_point t0;
+};
+
+#endif //CONVERGENCE_LOG_H
@@ -4,6 +4,7 @@
 class Displayable
 Derived Classes: class Space
 Abstract class to represent displayable objects, works as interface to Radiosity back-end.
+Ray casting systems request color per ray, rasterizing systems request the shaded quads themselves.
  */
 
 #ifndef DISPLAYABLE_H
@@ -11,11 +12,20 @@ Abstract class to represent displayable objects, works as interface to Radiosity
 
 #include "vec3.h"
 #include "ray.h"
+#include "quad.h"
+#include "face.h"
+#include <vector>
+#include <memory>
 
 class Displayable
 {
     public:
     virtual Color<int> request_color(Ray r, float tmin, float tmax) = 0;
+    virtual Color<float> request_radiance(Ray r, float tmin, float tmax) = 0;
+    virtual Color<float> request_radiance(Ray r, float tmin, float tmax, ElemIndex& i) = 0;
+    virtual Color<float> request_gathered_radiance(Ray r, float tmin, float tmax, ElemIndex& i) = 0;
+    virtual const std::vector<std::shared_ptr<Quad>>& request_quads()const = 0;
+    virtual std::vector<Face_grid> request_face_grids()const = 0;
 };
 
 #endif //DISPLAYABLE_H
@@ -16,7 +16,7 @@ v{},
 w{},
 corner_i{0},
 corners{},
-hm{100,100}
+hm{hm_xc,hm_yc}
 {
     v = MakeUnitVector(n);
     u = MakeUnitVector(Cross(hm.vup,v));
@@ -161,6 +161,22 @@ bool Element::get_ray(Ray& r){
     return true;
 }
 
+/* 
+void Element::reset_hemicube(int xc, int yc)
+Description:
+Rebuilds the HemiCube with a new resolution and rewinds get_ray to its first ray.
+
+Parameters: 
+int xc: Cube's Pixel Count per Face width.
+int yc: Cube's Pixel Count per Face height.
+
+Output: -
+ */
+void Element::reset_hemicube(int xc, int yc){
+    impl.hm = HemiCube{xc,yc};
+    impl.corner_i = 0;
+}
+
 
 /* 
 void Element::calc_ff(const Ray& ray, const Element_ref& j, Matrix<float,2>& ffm)
@@ -175,6 +191,22 @@ const Ray& ray: Ray that hit element j.
 Output: -
  */
 void Element::calc_ff(const Ray& ray, const Element_ref& j, Matrix<float,2>& ffm){
+    calc_ff(ray, j, &ffm(i,0));
+}
+
+/* 
+void Element::calc_ff(const Ray& ray, const Element_ref& j, float* row)
+Description:
+Calculates form-factor between two elements into this element's row of F.
+
+Parameters: 
+const Ray& ray: Ray that hit element j.
+ const Element_ref& j: Jth element hitted.
+ float* row: This element's Form-Factor row, indexed by element index.
+
+Output: -
+ */
+void Element::calc_ff(const Ray& ray, const Element_ref& j, float* row){
     float r = ray.get_direction().squared_norm();
     Vec3<float> ij = MakeUnitVector(ray.get_direction());
     Vec3<float> ji = MakeUnitVector(-ray.get_direction());
@@ -183,7 +215,7 @@ void Element::calc_ff(const Ray& ray, const Element_ref& j, Matrix<float,2>& ffm
     if(Dotji > 0.0f)
     {
         float Value{((dot(impl.v, ij) * Dotji * impl.hm.da) / ((float)M_PI  * r * r))};
-        ffm(i,j.i) += Value;
+        row[j.i] += Value;
     }
 }
 
@@ -90,7 +90,9 @@ class Element{
     Element& operator=(Element&&)=delete;
     
     bool get_ray(Ray& r);
+    void reset_hemicube(int xc, int yc);
     void calc_ff(const Ray& r, const Element_ref& j, Matrix<float,2>& ffm);
+    void calc_ff(const Ray& r, const Element_ref& j, float* row);
     ElemIndex get_index()const{return i;}
     
     Vec3<float> get_n()const{return n;}
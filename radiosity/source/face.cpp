@@ -1,4 +1,5 @@
 #include "face.h"
+#include "tone_map.h"
 
 
 /* 
@@ -304,7 +305,9 @@ Face(ei,1,1)
 /* 
 void Face::debug_print(std::string fn)
 Description:
-Prints first Vertex Color of each Quad within Face into PPM file.
+Prints first Vertex Color of each Quad within Face into PPM file. Vertex colors are radiance, the emitter 
+is far above 1, so they go through the same float path as HDR renders: tone mapped at exposure 1 into the PPM 
+(see tone_map.h) and written unclipped into a PFM next to it, fn with ".pfm" in place of its extension.
 
 Parameters: 
 std::string fn: FileName.
@@ -313,9 +316,22 @@ Output: -
  */
 void Face::debug_print(std::string fn)
 {
+    size_t rc = f.get_extent(0);
+    size_t cc = f.get_extent(1);
     /* 
     We will print it top to bottom!!!
      */
+    std::vector<float> radiance;
+    radiance.reserve(rc*cc*3);
+    for(int i=int(rc)-1;i>=0;--i){
+        for(size_t j=0;j<cc;++j){
+            Color<float> c = f(i,j)->c[2];
+            radiance.insert(radiance.end(), {c.r, c.g, c.b});
+        }
+    }
+    std::vector<unsigned char> ldr(radiance.size());
+    tone_map(radiance.data(), ldr.data(), radiance.size(), 1.0f);
+    
     std::ofstream ofs;
     ofs.open(fn, std::ios::trunc | std::ios::out);
     if(ofs.is_open())
@@ -323,21 +339,26 @@ void Face::debug_print(std::string fn)
         /* 
         First goes width then height
          */
-        ofs << "P3\n" << f.get_extent(1) << " " << f.get_extent(0) << "\n255\n";
-        
-        for(int i=f.get_extent(0)-1;i>=0;--i){
-            for(int j=0;j<f.get_extent(1);++j){
-                auto a=f(i,j);
-                Color<float> c = a->c[2];
-                int ir = int(255.99 * c.r);
-                int ig = int(255.99 * c.g);
-                int ib = int(255.99 * c.b);
-                ofs << std::to_string(ir) << " " << std::to_string(ig) << " " << std::to_string(ib) << std::endl;
-            }
+        ofs << "P3\n" << cc << " " << rc << "\n255\n";
+        for(size_t k=0;k<ldr.size();k+=3){
+            ofs << int(ldr[k]) << " " << int(ldr[k+1]) << " " << int(ldr[k+2]) << std::endl;
         }
         ofs.close();
     }
     else std::cout << "Unable to open file:" << fn << std::endl;
+    
+    std::string pfm = fn.substr(0, fn.find_last_of('.')) + ".pfm";
+    std::ofstream pfs(pfm, std::ios::trunc | std::ios::out | std::ios::binary);
+    if(!pfs.is_open())
+    {
+        std::cout << "Unable to open file:" << pfm << std::endl;
+        return;
+    }
+    // NOTE(Alex): PFM scanlines go bottom to top
+    pfs << "PF\n" << cc << " " << rc << "\n-1.0\n";
+    for(size_t r=rc;r-->0;){
+        pfs.write(reinterpret_cast<const char*>(radiance.data() + r*cc*3), std::streamsize(cc*3*sizeof(float)));
+    }
 }
 
 /* 
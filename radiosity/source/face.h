@@ -1,6 +1,12 @@
 /* date = March 24th 2021 11:43 am */
 
 
+/* 
+struct Face_grid
+referenced by: class Face, class H_matrix
+Element index layout of a Face, element (i,j) has index si + i*cc + j.
+ */
+
 /* 
 class Face
 Derived Classes: class Face_xy_z0,class Face_yz_x0,Face_xz_y0,Face_yz_x5,Face_xz_y5,Face_emissor
@@ -82,6 +88,12 @@ struct Mapping{
     Mapped_quad_bl bl;
 };
 
+struct Face_grid{
+    ElemIndex si;
+    size_t rc;
+    size_t cc;
+};
+
 class Face{
     public:
     Face(ElemIndex ei, size_t i, size_t j):
@@ -92,6 +104,7 @@ class Face{
     }
     void add_radiosities(const Matrix<float,1>& r,const Matrix<float,1>& g,const Matrix<float,1>& b);
     void debug_print(std::string fn);
+    Face_grid get_grid()const{return {si, f.get_extent(0), f.get_extent(1)};}
     protected:
     void generate_mapping();
     ElemIndex si;
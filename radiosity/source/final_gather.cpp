@@ -0,0 +1,273 @@
+#include "final_gather.h"
+#include <cmath>
+#include <cfloat>
+#include <mutex>
+#include <algorithm>
+#include "utility.h"
+
+#if !defined(M_PI)
+#define M_PI 3.14159265358979323846
+#endif
+
+/* 
+Final_gather constructor
+Description:
+Constructs a final gather pass over a solved scene.
+
+Parameters: 
+const Quad_manager& qm_: Scene geometry, MUST outlive the pass.
+float fw: Cornell Box Face Width, scales ray offsets and record radii.
+int s_: Directions per gather are s_ x s_.
+float a_: Irradiance cache error, smaller reuses records over shorter distances.
+std::vector<Color<float>> b_: Solved radiosity per element.
+std::vector<Color<float>> p_: Reflectivity per element.
+std::vector<Color<float>> e_: Emission per element.
+
+Output: -
+ */
+Final_gather::Final_gather(const Quad_manager& qm_, float fw, int s_, float a_, 
+                           std::vector<Color<float>> b_, std::vector<Color<float>> p_, std::vector<Color<float>> e_):
+qm{qm_},
+s{std::max(1, s_)},
+a{std::max(0.01f, a_)},
+r_min{0.005f * fw},
+r_max{0.1f * fw},
+cs{a * r_max},
+b{std::move(b_)},
+p{std::move(p_)},
+e{std::move(e_)},
+lights{},
+records{},
+cells{},
+m{},
+cache{true}
+{
+    for(auto& q:qm.get_quads()){
+        const Color<float>& eq = e[q->get_i()];
+        if(eq.r > 0.0f || eq.g > 0.0f || eq.b > 0.0f) lights.push_back(q.get());
+    }
+}
+
+/* 
+Color<float> Final_gather::get_radiance(Ray r, float tMin, float tMax, ElemIndex& i)
+Description:
+Gathered radiance of the closest quad hit by a ray, see final_gather.h.
+
+Parameters: 
+Ray r: Ray.
+float tMin: Ray minimum collision testing boundary. 
+float tMax: Ray maximum collision testing boundary. 
+ElemIndex& i: Element index of the hit quad, -1 on a miss.
+
+Output:
+Color<float>: Radiance, black on a miss.
+ */
+Color<float> Final_gather::get_radiance(Ray r, float tMin, float tMax, ElemIndex& i)
+{
+    HitRec rec{};
+    Quad* q = qm.closest_hit(r, tMin, tMax, rec);
+    i = q ? q->get_i() : -1;
+    if(!q) return {0,0,0};
+    
+    const Color<float>& pi = p[i];
+    const Color<float>& ei = e[i];
+    // NOTE(Alex): Nothing to gather on black elements, e.g. the area light
+    if(pi.r == 0.0f && pi.g == 0.0f && pi.b == 0.0f) return ei;
+    
+    Vec3<float> x = r.get_origin() + rec.t * r.get_direction();
+    Vec3<float> n = q->get_n();
+    Color<float> h{};
+    if(!cache || !lookup(x, n, h))
+    {
+        float rr = 0.0f;
+        h = gather(x, n, rr);
+        if(cache) insert({x, n, h, rr});
+    }
+    h += direct(x, n);
+    return {ei.r + pi.r*h.r, ei.g + pi.g*h.g, ei.b + pi.b*h.b};
+}
+
+/* 
+Color<float> Final_gather::gather(const Vec3<float>& x, const Vec3<float>& n, float& r)const
+Description:
+Samples H at x over s x s stratified cosine-weighted directions, the jitter is seeded by x so a 
+point always gathers the same directions.
+
+Parameters: 
+const Vec3<float>& x: World-Space point.
+const Vec3<float>& n: Surface normal at x.
+float& r: Harmonic mean distance to the surfaces seen, clamped to [r_min,r_max].
+
+Output:
+Color<float>: H, average reflected radiosity seen from x.
+ */
+Color<float> Final_gather::gather(const Vec3<float>& x, const Vec3<float>& n, float& r)const
+{
+    Vec3<float> t = MakeUnitVector(Cross(n, std::fabs(n.x) > 0.5f ? Vec3<float>{0,1,0} : Vec3<float>{1,0,0}));
+    Vec3<float> bt = Cross(n, t);
+    Vec3<float> o = x + r_min * 0.1f * n;
+    
+    uint64_t seed = Fnv1a(&x, sizeof(x));
+    if(seed == 0) seed = 1;
+    
+    Color<float> h{0,0,0};
+    float id = 0.0f;
+    float is = 1.0f / static_cast<float>(s);
+    for(int j = 0; j < s; ++j){
+        for(int k = 0; k < s; ++k){
+            float u1 = (static_cast<float>(j) + Xorshift_float(seed)) * is;
+            float u2 = (static_cast<float>(k) + Xorshift_float(seed)) * is;
+            float sr = std::sqrt(u1);
+            float phi = static_cast<float>(2.0 * M_PI) * u2;
+            Vec3<float> d = (sr * std::cos(phi)) * t + (sr * std::sin(phi)) * bt + std::sqrt(std::max(0.0f, 1.0f - u1)) * n;
+            
+            HitRec rec{};
+            Quad* q = qm.closest_hit(Ray{o, d}, 0.0001f, FLT_MAX, rec);
+            // NOTE(Alex): Rays leaving through the open front see black
+            if(!q) continue;
+            // NOTE(Alex): Emission is accounted for by direct
+            h += b[q->get_i()] - e[q->get_i()];
+            id += 1.0f / std::max(rec.t, 1e-6f);
+        }
+    }
+    float c = static_cast<float>(s * s);
+    r = id > 0.0f ? std::min(r_max, std::max(r_min, c / id)) : r_max;
+    return h * (1.0f / c);
+}
+
+/* 
+Color<float> Final_gather::direct(const Vec3<float>& x, const Vec3<float>& n)const
+Description:
+Direct part D at x, every emitting element is sampled with s/2 x s/2 stratified shadow rays:
+
+    F(x,l) ~ A_l / N * Sum V(x,y_k) cos_x cos_y / (pi r^2)
+
+Parameters: 
+const Vec3<float>& x: World-Space point.
+const Vec3<float>& n: Surface normal at x.
+
+Output:
+Color<float>: D.
+ */
+Color<float> Final_gather::direct(const Vec3<float>& x, const Vec3<float>& n)const
+{
+    Vec3<float> o = x + r_min * 0.1f * n;
+    uint64_t seed = Fnv1a(&x, sizeof(x), 0x9e3779b97f4a7c15ull);
+    if(seed == 0) seed = 1;
+    
+    Color<float> d{0,0,0};
+    int ls = std::max(1, s / 2);
+    float is = 1.0f / static_cast<float>(ls);
+    for(Quad* l:lights){
+        Vec3<float> p00 = l->get_point(0,0);
+        Vec3<float> du = l->get_point(1,0) - p00;
+        Vec3<float> dv = l->get_point(0,1) - p00;
+        float area = du.norm() * dv.norm();
+        Vec3<float> nl = l->get_n();
+        
+        float f = 0.0f;
+        for(int j = 0; j < ls; ++j){
+            for(int k = 0; k < ls; ++k){
+                float u = (static_cast<float>(j) + Xorshift_float(seed)) * is;
+                float v = (static_cast<float>(k) + Xorshift_float(seed)) * is;
+                Vec3<float> w = (p00 + u*du + v*dv) - o;
+                float r2 = w.squared_norm();
+                float cx = dot(n, w);
+                float cy = -dot(nl, w);
+                if(cx <= 0.0f || cy <= 0.0f) continue;
+                
+                if(qm.occluded(Ray{o, w}, 0.0001f, 0.9999f, l)) continue;
+                f += cx * cy / (r2 * r2);
+            }
+        }
+        f *= area * is * is / static_cast<float>(M_PI);
+        d += f * e[l->get_i()];
+    }
+    return d;
+}
+
+/* 
+uint64_t Final_gather::get_cell(int cx, int cy, int cz)const
+Description:
+Hash grid key of a cell.
+ */
+uint64_t Final_gather::get_cell(int cx, int cy, int cz)const
+{
+    int c[3] = {cx, cy, cz};
+    return Fnv1a(c, sizeof(c));
+}
+
+/* 
+bool Final_gather::lookup(const Vec3<float>& x, const Vec3<float>& n, Color<float>& h)
+Description:
+Interpolates H at x from the cached records that pass the error test.
+
+Parameters: 
+const Vec3<float>& x: World-Space point.
+const Vec3<float>& n: Surface normal at x.
+Color<float>& h: Interpolated H.
+
+Output:
+bool: Whether any record was usable.
+ */
+bool Final_gather::lookup(const Vec3<float>& x, const Vec3<float>& n, Color<float>& h)
+{
+    std::shared_lock<std::shared_mutex> l{m};
+    auto it = cells.find(get_cell(int(std::floor(x.x / cs)), int(std::floor(x.y / cs)), int(std::floor(x.z / cs))));
+    if(it == cells.end()) return false;
+    
+    Color<float> acc{0,0,0};
+    float wc = 0.0f;
+    for(size_t ri:it->second){
+        const Record& rec = records[ri];
+        float nd = dot(n, rec.n);
+        if(nd <= 0.0f) continue;
+        float den = (x - rec.p).norm() / rec.r + std::sqrt(std::max(0.0f, 1.0f - nd));
+        if(den >= a) continue;
+        float w = 1.0f / std::max(den, 1e-6f);
+        acc += w * rec.h;
+        wc += w;
+    }
+    if(wc == 0.0f) return false;
+    h = acc * (1.0f / wc);
+    return true;
+}
+
+/* 
+void Final_gather::insert(const Record& rec)
+Description:
+Stores a record in every cell its region of use (radius a * R) overlaps.
+
+Parameters: 
+const Record& rec: New record.
+
+Output: -
+ */
+void Final_gather::insert(const Record& rec)
+{
+    std::unique_lock<std::shared_mutex> l{m};
+    size_t ri = records.size();
+    records.push_back(rec);
+    float ir = a * rec.r;
+    int x0 = int(std::floor((rec.p.x - ir) / cs)), x1 = int(std::floor((rec.p.x + ir) / cs));
+    int y0 = int(std::floor((rec.p.y - ir) / cs)), y1 = int(std::floor((rec.p.y + ir) / cs));
+    int z0 = int(std::floor((rec.p.z - ir) / cs)), z1 = int(std::floor((rec.p.z + ir) / cs));
+    for(int cx = x0; cx <= x1; ++cx){
+        for(int cy = y0; cy <= y1; ++cy){
+            for(int cz = z0; cz <= z1; ++cz){
+                cells[get_cell(cx, cy, cz)].push_back(ri);
+            }
+        }
+    }
+}
+
+/* 
+size_t Final_gather::get_record_count()
+Description:
+Gathers run so far, every other pixel was served from the cache.
+ */
+size_t Final_gather::get_record_count()
+{
+    std::shared_lock<std::shared_mutex> l{m};
+    return records.size();
+}
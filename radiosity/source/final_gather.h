@@ -0,0 +1,79 @@
+/* date = October 19th 2026 11:20 pm */
+
+/* 
+class Final_gather
+referenced by: class Radiosity
+Per-pixel final gather on top of the radiosity solution. 
+Bilinear vertex colors smear shadows and show Mach bands at coarse meshes, instead at a visible point x 
+on element i the reflected part is gathered again from the solved B of whatever the hemisphere sees:
+
+    B(x) = E_i + P_i * (D(x) + H(x))
+
+The direct part D sums E_l * F(x,l) over the emitting elements l, the point to element form factor is 
+estimated with s/2 x s/2 stratified shadow rays onto l, so shadows stay sharp. The indirect part 
+
+    H(x) = 1/pi Integral (B(y) - E(y)) cos dw ~ average of B(y_k) - E(y_k), y_k cosine-weighted
+
+is sampled on a stratified s x s cosine-weighted grid of directions. H is smooth but expensive so it is kept 
+in an irradiance cache (Ward et al.): every gather stores a record with its position, normal and harmonic 
+mean distance R to the surfaces it saw, and is reused at x when
+
+    w = 1 / (|x - p| / R + sqrt(1 - n . n_p)) > 1 / a
+
+interpolating H from all usable records weighted by w. Records are view independent, every view, tile and 
+thread shares them. The cache is a hash grid of cells a * r_max wide guarded by a shared_mutex, lookups 
+take the shared lock and only new records take the exclusive one. 
+NOTE: Which pixel creates a record depends on thread timing, so multithreaded renders with the cache may differ 
+in the last bits between runs. set_cache(false) gathers H at every point instead: far more rays, but a pixel 
+only depends on its own point, so renders are bit-identical for any thread count (Radiosity's deterministic mode).
+
+References:
+G. J. Ward, F. M. Rubinstein, R. D. Clear. A ray tracing solution for diffuse interreflection. SIGGRAPH '88, pp. 85-92.
+ */
+
+#ifndef FINAL_GATHER_H
+#define FINAL_GATHER_H
+
+#include <vector>
+#include <unordered_map>
+#include <shared_mutex>
+#include "vec3.h"
+#include "ray.h"
+#include "quad_manager.h"
+
+class Final_gather{
+    public:
+    Final_gather(const Quad_manager& qm_, float fw, int s_, float a_, 
+                 std::vector<Color<float>> b_, std::vector<Color<float>> p_, std::vector<Color<float>> e_);
+    Color<float> get_radiance(Ray r, float tMin, float tMax, ElemIndex& i);
+    size_t get_record_count();
+    void set_cache(bool c){cache = c;}
+    private:
+    struct Record{
+        Vec3<float> p;
+        Vec3<float> n;
+        Color<float> h;
+        float r;
+    };
+    Color<float> gather(const Vec3<float>& x, const Vec3<float>& n, float& r)const;
+    Color<float> direct(const Vec3<float>& x, const Vec3<float>& n)const;
+    bool lookup(const Vec3<float>& x, const Vec3<float>& n, Color<float>& h);
+    void insert(const Record& rec);
+    uint64_t get_cell(int cx, int cy, int cz)const;
+    const Quad_manager& qm;
+    int s;
+    float a;
+    float r_min;
+    float r_max;
+    float cs;
+    std::vector<Color<float>> b;
+    std::vector<Color<float>> p;
+    std::vector<Color<float>> e;
+    std::vector<Quad*> lights;
+    std::vector<Record> records;
+    std::unordered_map<uint64_t, std::vector<size_t>> cells;
+    std::shared_mutex m;
+    bool cache;
+};
+
+#endif //FINAL_GATHER_H
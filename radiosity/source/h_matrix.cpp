@@ -0,0 +1,575 @@
+#include "h_matrix.h"
+#include <algorithm>
+#include <cmath>
+
+/* 
+leaf_size: Maximum element count of a leaf cluster.
+eta: Admissibility parameter.
+aca_eps: Relative Frobenius tolerance of each low-rank block, per row in the streamed build.
+ */
+static const size_t leaf_size = 32;
+static const float eta = 0.8f;
+static const float aca_eps = 1e-4f;
+
+/* 
+H_matrix Constructor
+Description:
+Builds the cluster tree from Face grids and compresses f block by block. f is only read, 
+so it may be a memory-mapped Form-Factor matrix that does not fit in memory.
+
+Parameters: 
+const Matrix<float,2>& f: Form-Factor matrix.
+const std::vector<Face_grid>& g: Element index layout of every Face.
+const std::vector<Vec3<float>>& p: Element positions, indexed by element index.
+
+Output: -
+ */
+H_matrix::H_matrix(const Matrix<float,2>& f, const std::vector<Face_grid>& g, const std::vector<Vec3<float>>& p):
+n{f.get_extent(0)},
+clusters{},
+blocks{},
+row_blocks{},
+leaf{},
+x{},
+acc{mem_category::matrix}
+{
+    int root = build_clusters(g, p);
+    build(f, root, root);
+    acc.set(get_bytes());
+}
+
+/* 
+H_matrix Constructor
+Description:
+Streamed build: builds the cluster tree and lays out the blocks, empty, for add_row to fill in. 
+Dense leaf blocks are allocated by their first non-zero row, so coplanar pairs never take storage, 
+low-rank blocks grow with their rank.
+
+Parameters: 
+const std::vector<Face_grid>& g: Element index layout of every Face.
+const std::vector<Vec3<float>>& p: Element positions, indexed by element index.
+
+Output: -
+ */
+H_matrix::H_matrix(const std::vector<Face_grid>& g, const std::vector<Vec3<float>>& p):
+n{p.size()},
+clusters{},
+blocks{},
+row_blocks(p.size()),
+leaf{},
+x{},
+acc{mem_category::matrix}
+{
+    int root = build_clusters(g, p);
+    partition(root, root);
+    for(size_t bi = 0; bi < blocks.size(); ++bi){
+        const std::vector<int>& si = clusters[blocks[bi].s].idx;
+        for(size_t a = 0; a < si.size(); ++a) row_blocks[si[a]].push_back({bi, a});
+    }
+    acc.set(get_bytes());
+}
+
+/* 
+int H_matrix::build_clusters(const std::vector<Face_grid>& g, const std::vector<Vec3<float>>& p)
+Description:
+Builds the cluster tree, one child of the root per Face.
+
+Parameters: 
+const std::vector<Face_grid>& g: Element index layout of every Face.
+const std::vector<Vec3<float>>& p: Element positions.
+
+Output:
+int: Root cluster index.
+ */
+int H_matrix::build_clusters(const std::vector<Face_grid>& g, const std::vector<Vec3<float>>& p){
+    std::vector<int> ch;
+    for(auto& a:g) ch.push_back(split_grid(a, 0, a.rc, 0, a.cc, p));
+    std::vector<int> idx(n);
+    for(size_t i = 0; i < n; ++i) idx[i] = static_cast<int>(i);
+    int root = add_cluster(std::move(idx), p);
+    clusters[root].children = ch;
+    return root;
+}
+
+/* 
+int H_matrix::add_cluster(std::vector<int> idx, const std::vector<Vec3<float>>& p)
+Description:
+Appends a cluster and computes its bounding box.
+
+Parameters: 
+std::vector<int> idx: Element indices of the cluster.
+const std::vector<Vec3<float>>& p: Element positions.
+
+Output:
+int: Cluster index.
+ */
+int H_matrix::add_cluster(std::vector<int> idx, const std::vector<Vec3<float>>& p){
+    H_cluster c{};
+    c.lo = p[idx[0]];
+    c.hi = p[idx[0]];
+    for(auto i:idx){
+        c.lo = {std::min(c.lo.x, p[i].x), std::min(c.lo.y, p[i].y), std::min(c.lo.z, p[i].z)};
+        c.hi = {std::max(c.hi.x, p[i].x), std::max(c.hi.y, p[i].y), std::max(c.hi.z, p[i].z)};
+    }
+    c.idx = std::move(idx);
+    clusters.push_back(std::move(c));
+    return static_cast<int>(clusters.size() - 1);
+}
+
+/* 
+int H_matrix::split_grid(const Face_grid& g, size_t i0, size_t i1, size_t j0, size_t j1, const std::vector<Vec3<float>>& p)
+Description:
+Clusters rectangle [i0,i1) x [j0,j1) of a Face grid, halving its longer side until it holds at most leaf_size elements.
+
+Parameters: 
+const Face_grid& g: Face grid.
+size_t i0, i1: Row range.
+size_t j0, j1: Column range.
+const std::vector<Vec3<float>>& p: Element positions.
+
+Output:
+int: Cluster index.
+ */
+int H_matrix::split_grid(const Face_grid& g, size_t i0, size_t i1, size_t j0, size_t j1, const std::vector<Vec3<float>>& p){
+    std::vector<int> idx;
+    for(size_t i = i0; i < i1; ++i){
+        for(size_t j = j0; j < j1; ++j){
+            idx.push_back(static_cast<int>(g.si + i*g.cc + j));
+        }
+    }
+    std::vector<int> ch;
+    if(idx.size() > leaf_size)
+    {
+        if(i1 - i0 >= j1 - j0)
+        {
+            size_t im = (i0 + i1) / 2;
+            ch.push_back(split_grid(g, i0, im, j0, j1, p));
+            ch.push_back(split_grid(g, im, i1, j0, j1, p));
+        }
+        else
+        {
+            size_t jm = (j0 + j1) / 2;
+            ch.push_back(split_grid(g, i0, i1, j0, jm, p));
+            ch.push_back(split_grid(g, i0, i1, jm, j1, p));
+        }
+    }
+    int c = add_cluster(std::move(idx), p);
+    clusters[c].children = ch;
+    return c;
+}
+
+/* 
+bool H_matrix::admissible(int s, int t)const
+Description:
+Standard admissibility condition on cluster bounding boxes.
+
+Parameters: 
+int s: Row cluster.
+int t: Column cluster.
+
+Output:
+bool: Whether block (s,t) may be approximated as low-rank.
+ */
+bool H_matrix::admissible(int s, int t)const{
+    const H_cluster& a = clusters[s];
+    const H_cluster& b = clusters[t];
+    float ds = (a.hi - a.lo).norm();
+    float dt = (b.hi - b.lo).norm();
+    Vec3<float> gap{
+        std::max(0.0f, std::max(b.lo.x - a.hi.x, a.lo.x - b.hi.x)),
+        std::max(0.0f, std::max(b.lo.y - a.hi.y, a.lo.y - b.hi.y)),
+        std::max(0.0f, std::max(b.lo.z - a.hi.z, a.lo.z - b.hi.z))};
+    float dist = gap.norm();
+    return dist > 0.0f && std::min(ds, dt) <= eta * dist;
+}
+
+/* 
+void H_matrix::build(const Matrix<float,2>& f, int s, int t)
+Description:
+Recursive block partitioning. Admissible blocks are compressed with ACA, a block whose ACA 
+does not pay off or that is not admissible is refined through the children of s and t, 
+pairs of leaves are stored dense.
+
+Parameters: 
+const Matrix<float,2>& f: Form-Factor matrix.
+int s: Row cluster.
+int t: Column cluster.
+
+Output: -
+ */
+void H_matrix::build(const Matrix<float,2>& f, int s, int t){
+    if(admissible(s,t))
+    {
+        H_block b{};
+        b.s = s;
+        b.t = t;
+        if(aca(f, b))
+        {
+            if(b.r > 0) blocks.push_back(std::move(b));
+            return;
+        }
+    }
+    bool sl = clusters[s].children.empty();
+    bool tl = clusters[t].children.empty();
+    if(sl && tl)
+    {
+        add_dense(f, s, t);
+        return;
+    }
+    std::vector<int> sc = sl ? std::vector<int>{s} : clusters[s].children;
+    std::vector<int> tc = tl ? std::vector<int>{t} : clusters[t].children;
+    for(auto a:sc){
+        for(auto b:tc){
+            build(f, a, b);
+        }
+    }
+}
+
+/* 
+void H_matrix::add_dense(const Matrix<float,2>& f, int s, int t)
+Description:
+Stores block (s,t) dense, blocks without a single non-zero entry are dropped.
+
+Parameters: 
+const Matrix<float,2>& f: Form-Factor matrix.
+int s: Row cluster.
+int t: Column cluster.
+
+Output: -
+ */
+void H_matrix::add_dense(const Matrix<float,2>& f, int s, int t){
+    const std::vector<int>& si = clusters[s].idx;
+    const std::vector<int>& ti = clusters[t].idx;
+    H_block b{};
+    b.s = s;
+    b.t = t;
+    b.r = 0;
+    b.d.resize(si.size()*ti.size());
+    bool nz = false;
+    for(size_t a = 0; a < si.size(); ++a){
+        for(size_t c = 0; c < ti.size(); ++c){
+            float v = f(si[a], ti[c]);
+            b.d[a*ti.size() + c] = v;
+            nz = nz || v != 0.0f;
+        }
+    }
+    if(nz) blocks.push_back(std::move(b));
+}
+
+/* 
+bool H_matrix::aca(const Matrix<float,2>& f, H_block& b)const
+Description:
+Adaptive Cross Approximation with partial pivoting. Each step takes the residual row of the 
+pivot row, its largest entry as pivot column and the residual column, until the new rank-1 
+term is below aca_eps relative to the approximation. Rows that are already exact are skipped, 
+so all-zero blocks end with rank 0.
+
+Parameters: 
+const Matrix<float,2>& f: Form-Factor matrix.
+H_block& b: Block with s and t set, u, v and r are filled in.
+
+Output:
+bool: Whether the block got a rank below half its smaller side, dense is cheaper otherwise.
+ */
+bool H_matrix::aca(const Matrix<float,2>& f, H_block& b)const{
+    const std::vector<int>& si = clusters[b.s].idx;
+    const std::vector<int>& ti = clusters[b.t].idx;
+    size_t m = si.size();
+    size_t k = ti.size();
+    size_t max_r = std::min(m,k) / 2;
+    std::vector<char> used(m, 0);
+    std::vector<float> row(k);
+    std::vector<float> col(m);
+    double s2 = 0.0;
+    size_t r = 0;
+    size_t i = 0;
+    for(;;){
+        used[i] = 1;
+        for(size_t c = 0; c < k; ++c){
+            float v = f(si[i], ti[c]);
+            for(size_t l = 0; l < r; ++l) v -= b.u[l*m + i]*b.v[l*k + c];
+            row[c] = v;
+        }
+        size_t jp = 0;
+        for(size_t c = 1; c < k; ++c) if(std::fabs(row[c]) > std::fabs(row[jp])) jp = c;
+        
+        float pv = std::fabs(row[jp]);
+        if(pv == 0.0f || (s2 > 0.0 && pv*std::sqrt(double(m*k)) <= aca_eps*std::sqrt(s2)))
+        {
+            // NOTE(Alex): Row is already approximated, try the next one
+            size_t a = 0;
+            while(a < m && used[a]) ++a;
+            if(a == m) break;
+            i = a;
+            continue;
+        }
+        if(r == max_r) return false;
+        
+        float ip = 1.0f / row[jp];
+        for(size_t a = 0; a < m; ++a){
+            float v = f(si[a], ti[jp]);
+            for(size_t l = 0; l < r; ++l) v -= b.u[l*m + a]*b.v[l*k + jp];
+            col[a] = v;
+        }
+        double nu = 0.0;
+        double nv = 0.0;
+        double cross = 0.0;
+        for(size_t a = 0; a < m; ++a) nu += double(col[a])*col[a];
+        for(size_t c = 0; c < k; ++c) nv += double(row[c]*ip)*(row[c]*ip);
+        for(size_t l = 0; l < r; ++l){
+            double du = 0.0;
+            double dv = 0.0;
+            for(size_t a = 0; a < m; ++a) du += double(b.u[l*m + a])*col[a];
+            for(size_t c = 0; c < k; ++c) dv += double(b.v[l*k + c])*(row[c]*ip);
+            cross += du*dv;
+        }
+        b.u.insert(b.u.end(), col.begin(), col.end());
+        for(size_t c = 0; c < k; ++c) b.v.push_back(row[c]*ip);
+        ++r;
+        s2 += nu*nv + 2.0*cross;
+        if(std::sqrt(nu*nv) <= aca_eps*std::sqrt(s2)) break;
+        
+        size_t a_max = m;
+        for(size_t a = 0; a < m; ++a){
+            if(!used[a] && (a_max == m || std::fabs(col[a]) > std::fabs(col[a_max]))) a_max = a;
+        }
+        if(a_max == m) break;
+        i = a_max;
+    }
+    b.r = r;
+    return true;
+}
+
+/* 
+void H_matrix::partition(int s, int t)
+Description:
+Streamed build block layout: admissible blocks become empty low-rank blocks, pairs of leaves dense blocks, 
+the rest is refined through the children of s and t.
+
+Parameters: 
+int s: Row cluster.
+int t: Column cluster.
+
+Output: -
+ */
+void H_matrix::partition(int s, int t){
+    bool sl = clusters[s].children.empty();
+    bool tl = clusters[t].children.empty();
+    if(admissible(s,t) || (sl && tl))
+    {
+        H_block b{};
+        b.s = s;
+        b.t = t;
+        b.r = 0;
+        leaf.push_back(admissible(s,t) ? 0 : 1);
+        blocks.push_back(std::move(b));
+        return;
+    }
+    std::vector<int> sc = sl ? std::vector<int>{s} : clusters[s].children;
+    std::vector<int> tc = tl ? std::vector<int>{t} : clusters[t].children;
+    for(auto a:sc){
+        for(auto b:tc){
+            partition(a, b);
+        }
+    }
+}
+
+/* 
+void H_matrix::add_row(size_t i, const float* row)
+Description:
+Streamed build: hands row i of F to every block whose row cluster holds element i. 
+Every row MUST be added once, before finish.
+
+Parameters: 
+size_t i: Element index.
+const float* row: Row i of F, n floats.
+
+Output: -
+ */
+void H_matrix::add_row(size_t i, const float* row){
+    for(auto& rb:row_blocks[i]) stream_row(rb.first, rb.second, row);
+}
+
+/* 
+void H_matrix::stream_row(size_t bi, size_t a, const float* row)
+Description:
+Adds the a-th row of block bi. Dense blocks copy it, low-rank blocks project it onto their orthonormal 
+basis V (Gram-Schmidt, twice for stability) and store the coefficients in U. A remainder over aca_eps 
+of the row becomes a new basis row, past half the smaller side of the block it turns dense.
+
+Parameters: 
+size_t bi: Block index.
+size_t a: Row within the block.
+const float* row: Row of F, n floats.
+
+Output: -
+ */
+void H_matrix::stream_row(size_t bi, size_t a, const float* row){
+    H_block& b = blocks[bi];
+    const std::vector<int>& ti = clusters[b.t].idx;
+    size_t m = clusters[b.s].idx.size();
+    size_t k = ti.size();
+    if(leaf[bi] && b.d.empty())
+    {
+        if(std::all_of(ti.begin(), ti.end(), [row](int j){return row[j] == 0.0f;})) return;
+        b.d.assign(m*k, 0.0f);
+        acc.set(acc.get_bytes() + m*k*sizeof(float));
+    }
+    if(!b.d.empty())
+    {
+        for(size_t c = 0; c < k; ++c) b.d[a*k + c] = row[ti[c]];
+        return;
+    }
+    x.resize(k);
+    double xn = 0.0;
+    for(size_t c = 0; c < k; ++c){
+        x[c] = row[ti[c]];
+        xn += x[c]*x[c];
+    }
+    if(xn == 0.0) return;
+    for(int pass = 0; pass < 2; ++pass){
+        for(size_t l = 0; l < b.r; ++l){
+            const float* vl = b.v.data() + l*k;
+            double d = 0.0;
+            for(size_t c = 0; c < k; ++c) d += vl[c]*x[c];
+            for(size_t c = 0; c < k; ++c) x[c] -= d*vl[c];
+            b.u[l*m + a] += float(d);
+        }
+    }
+    double rn = 0.0;
+    for(size_t c = 0; c < k; ++c) rn += x[c]*x[c];
+    rn = std::sqrt(rn);
+    if(rn <= aca_eps*std::sqrt(xn)) return;
+    if(b.r == std::min(m,k) / 2)
+    {
+        acc.set(acc.get_bytes() + m*k*sizeof(float) - (b.u.size() + b.v.size())*sizeof(float));
+        to_dense(b);
+        for(size_t c = 0; c < k; ++c) b.d[a*k + c] = row[ti[c]];
+        return;
+    }
+    acc.set(acc.get_bytes() + (m + k)*sizeof(float));
+    b.u.resize((b.r + 1)*m, 0.0f);
+    b.u[b.r*m + a] = float(rn);
+    for(size_t c = 0; c < k; ++c) b.v.push_back(float(x[c] / rn));
+    ++b.r;
+}
+
+/* 
+void H_matrix::to_dense(H_block& b)const
+Description:
+Expands a low-rank block into a dense one, rows not added yet stay zero.
+
+Parameters: 
+H_block& b: Low-rank block.
+
+Output: -
+ */
+void H_matrix::to_dense(H_block& b)const{
+    size_t m = clusters[b.s].idx.size();
+    size_t k = clusters[b.t].idx.size();
+    b.d.assign(m*k, 0.0f);
+    for(size_t l = 0; l < b.r; ++l){
+        for(size_t a = 0; a < m; ++a){
+            float ua = b.u[l*m + a];
+            for(size_t c = 0; c < k; ++c) b.d[a*k + c] += ua*b.v[l*k + c];
+        }
+    }
+    b.u = std::vector<float>{};
+    b.v = std::vector<float>{};
+    b.r = 0;
+}
+
+/* 
+void H_matrix::finish()
+Description:
+Streamed build: drops blocks that stayed all zero and the streaming bookkeeping, once every row was added.
+
+Parameters: 
+
+Output: -
+ */
+void H_matrix::finish(){
+    auto zero = [](const H_block& b){
+        if(b.d.empty()) return b.r == 0;
+        return std::all_of(b.d.begin(), b.d.end(), [](float v){return v == 0.0f;});
+    };
+    blocks.erase(std::remove_if(blocks.begin(), blocks.end(), zero), blocks.end());
+    for(auto& b:blocks){
+        b.u.shrink_to_fit();
+        b.v.shrink_to_fit();
+    }
+    blocks.shrink_to_fit();
+    row_blocks = std::vector<std::vector<std::pair<size_t,size_t>>>{};
+    leaf = std::vector<char>{};
+    x = std::vector<double>{};
+    acc.set(get_bytes());
+}
+
+/* 
+size_t H_matrix::get_bytes()const
+Description:
+Storage held by blocks and cluster tree.
+
+Parameters: 
+
+Output:
+size_t: Bytes.
+ */
+size_t H_matrix::get_bytes()const{
+    size_t s = 0;
+    for(auto& b:blocks) s += (b.d.size() + b.u.size() + b.v.size())*sizeof(float);
+    for(auto& c:clusters) s += (c.idx.size() + c.children.size())*sizeof(int);
+    return s;
+}
+
+/* 
+Matrix<float,1> mult_m(const H_matrix& m1, const Matrix<float,1>& m2)
+Description:
+H-matrix vector product, dense blocks multiply directly and low-rank blocks as U (V^T x).
+
+Parameters: 
+const H_matrix& m1: H-matrix.
+const Matrix<float,1>& m2: Vector.
+
+Output:
+Matrix<float,1>: m1 m2.
+ */
+Matrix<float,1> mult_m(const H_matrix& m1, const Matrix<float,1>& m2){
+    assert(m1.get_extent(1)==m2.get_extent());
+    Matrix<float,1> res(m1.get_extent(0));
+    const std::vector<H_cluster>& cs = m1.get_clusters();
+    std::vector<float> xt;
+    std::vector<float> tmp;
+    for(auto& b:m1.get_blocks()){
+        const std::vector<int>& si = cs[b.s].idx;
+        const std::vector<int>& ti = cs[b.t].idx;
+        size_t m = si.size();
+        size_t k = ti.size();
+        xt.resize(k);
+        for(size_t c = 0; c < k; ++c) xt[c] = m2(ti[c]);
+        if(!b.d.empty())
+        {
+            for(size_t a = 0; a < m; ++a){
+                const float* dr = b.d.data() + a*k;
+                float s{};
+                for(size_t c = 0; c < k; ++c) s += dr[c]*xt[c];
+                res(si[a]) += s;
+            }
+        }
+        else
+        {
+            tmp.assign(b.r, 0.0f);
+            for(size_t l = 0; l < b.r; ++l){
+                const float* vl = b.v.data() + l*k;
+                float s{};
+                for(size_t c = 0; c < k; ++c) s += vl[c]*xt[c];
+                tmp[l] = s;
+            }
+            for(size_t l = 0; l < b.r; ++l){
+                const float* ul = b.u.data() + l*m;
+                for(size_t a = 0; a < m; ++a) res(si[a]) += ul[a]*tmp[l];
+            }
+        }
+    }
+    return res;
+}
@@ -0,0 +1,106 @@
+/* date = October 19th 2026 4:20 pm */
+
+/* 
+class H_matrix
+referenced by: class Radiosity, class Stimuli
+Hierarchical (H-matrix) representation of the Form-Factor matrix.
+
+Elements are clustered by their Face grids: the root holds every element, its children are the 
+Faces, and each Face grid is split recursively into rectangles of elements down to leaf_size. 
+A block (s,t) of F is admissible when its clusters are far apart compared to their size:
+
+min(diam(s), diam(t)) <= eta * dist(s,t)
+
+Admissible blocks, e.g. Face_yz_x0 against Face_yz_x5, are smooth and get approximated as U V^T 
+with rank r << size. The rest is refined down to leaf blocks stored dense, blocks that are all zero 
+(coplanar elements) are not stored at all. Storage is O(n log n) for this kind of scene, and so is the cost of mult_m.
+
+There are two ways to build it:
+-From a dense F: admissible blocks are compressed by Adaptive Cross Approximation, a block whose ACA does 
+ not pay off is refined through its children. Handy for comparisons, but F has to exist first.
+-Streamed, the solver's way: the constructor without F lays out the blocks from the geometry alone, then 
+ add_row takes F one row at a time as the HemiCubes cast them, and finish closes it. Dense F is never stored, 
+ peak storage is the H-matrix itself plus the rows in flight, so scenes far past in_core_bytes still fit. 
+ An admissible block keeps an orthonormal basis V of the rows it has seen, a new row adds its projection to U 
+ and only its part outside V (over aca_eps of the row) as a new basis row. 
+ LIMIT: rows can not be revisited, so a block whose rank outgrows half its smaller side turns dense 
+ instead of being refined through its children like ACA does, its storage is then m x k.
+
+References:
+M. Bebendorf. Approximation of boundary element matrices. Numerische Mathematik 86 (2000), pp. 565-589.
+ */
+
+/* 
+struct H_cluster
+referenced by: class H_matrix
+Node of the cluster tree, a set of element indices and their bounding box.
+ */
+
+/* 
+struct H_block
+referenced by: class H_matrix
+Leaf of the block tree, either dense (d, row-major) or low-rank (u,v column-major with rank r).
+ */
+
+#ifndef H_MATRIX_H
+#define H_MATRIX_H
+
+#include <vector>
+#include "matrix.h"
+#include "face.h"
+#include "mem_accounting.h"
+
+struct H_cluster{
+    std::vector<int> idx;
+    Vec3<float> lo;
+    Vec3<float> hi;
+    std::vector<int> children;
+};
+
+struct H_block{
+    int s;
+    int t;
+    size_t r;
+    std::vector<float> d;
+    std::vector<float> u;
+    std::vector<float> v;
+};
+
+class H_matrix{
+    public:
+    H_matrix(const Matrix<float,2>& f, const std::vector<Face_grid>& g, const std::vector<Vec3<float>>& p);
+    H_matrix(const std::vector<Face_grid>& g, const std::vector<Vec3<float>>& p);
+    void add_row(size_t i, const float* row);
+    void finish();
+    
+    size_t get_extent(size_t i)const{return (i<=1) ? n : 0;}
+    size_t get_bytes()const;
+    size_t get_block_count()const{return blocks.size();}
+    const std::vector<H_cluster>& get_clusters()const{return clusters;}
+    const std::vector<H_block>& get_blocks()const{return blocks;}
+    
+    private:
+    int build_clusters(const std::vector<Face_grid>& g, const std::vector<Vec3<float>>& p);
+    int add_cluster(std::vector<int> idx, const std::vector<Vec3<float>>& p);
+    int split_grid(const Face_grid& g, size_t i0, size_t i1, size_t j0, size_t j1, const std::vector<Vec3<float>>& p);
+    bool admissible(int s, int t)const;
+    void build(const Matrix<float,2>& f, int s, int t);
+    bool aca(const Matrix<float,2>& f, H_block& b)const;
+    void add_dense(const Matrix<float,2>& f, int s, int t);
+    void partition(int s, int t);
+    void stream_row(size_t bi, size_t a, const float* row);
+    void to_dense(H_block& b)const;
+    
+    size_t n;
+    std::vector<H_cluster> clusters;
+    std::vector<H_block> blocks;
+    // NOTE(Alex): Streamed build only, per element the blocks its row feeds and its row within each
+    std::vector<std::vector<std::pair<size_t,size_t>>> row_blocks;
+    std::vector<char> leaf;
+    std::vector<double> x;
+    Mem_account acc;
+};
+
+Matrix<float,1> mult_m(const H_matrix& m1, const Matrix<float,1>& m2);
+
+#endif //H_MATRIX_H
@@ -17,6 +17,10 @@ COHEN, M.F., AND GREENBERG, D.P. The hemi-cube: A radiosity solution for complex
 
 class Element;
 
+// NOTE(Alex): HemiCube resolution used by every Element
+const int hm_xc = 100;
+const int hm_yc = 100;
+
 struct HemiCube{
     HemiCube(){}
     HemiCube(int xc, int yc);
@@ -0,0 +1,122 @@
+#include "instrumentation.h"
+
+#if defined(RADIOSITY_INSTRUMENT)
+
+#include <map>
+#include <set>
+#include <mutex>
+#include <fstream>
+#include <iostream>
+#include <cstdlib>
+
+/* 
+Global state, reached through get_state so it outlives every thread_local block that flushes into it.
+ */
+struct Instrument_state{
+    std::mutex m;
+    uint64_t totals[static_cast<int>(instrument_counter::count)]{};
+    std::set<const Instrument_block*> live;
+    std::map<std::string, std::pair<double,uint64_t>> phases;
+    std::map<std::string, double> values;
+};
+
+static const char* counter_names[]{"rays_cast", "ray_hits", "ray_misses", "quads_tested", "gs_sweeps"};
+
+static Instrument_state& get_state()
+{
+    // NOTE(Alex): Never destroyed, thread blocks may flush during static destruction
+    static Instrument_state* s = new Instrument_state{};
+    return *s;
+}
+
+/* 
+void dump_instrumentation()
+Description:
+Writes phases, counters (finished threads plus live blocks) and values into "instrumentation.json".
+
+Parameters: 
+
+Output: -
+ */
+static void dump_instrumentation()
+{
+    Instrument_state& s = get_state();
+    std::lock_guard<std::mutex> l{s.m};
+    uint64_t c[static_cast<int>(instrument_counter::count)];
+    for(int i = 0; i < static_cast<int>(instrument_counter::count); ++i){
+        c[i] = s.totals[i];
+        for(const Instrument_block* b : s.live) c[i] += b->c[i];
+    }
+    
+    std::ofstream o{"instrumentation.json"};
+    if(!o)
+    {
+        std::cout << "Unable to open file:instrumentation.json" << std::endl;
+        return;
+    }
+    o << "{\"phases\":{";
+    const char* sep = "";
+    for(auto& p : s.phases){
+        o << sep << "\n \"" << p.first << "\":{\"seconds\":" << p.second.first << ",\"calls\":" << p.second.second << "}";
+        sep = ",";
+    }
+    o << "},\n\"counters\":{";
+    for(int i = 0; i < static_cast<int>(instrument_counter::count); ++i){
+        o << (i ? "," : "") << "\n \"" << counter_names[i] << "\":" << c[i];
+    }
+    o << "},\n\"values\":{";
+    sep = "";
+    for(auto& v : s.values){
+        o << sep << "\n \"" << v.first << "\":" << v.second;
+        sep = ",";
+    }
+    o << "}}\n";
+}
+
+/* 
+Registers dump_instrumentation once, the first time any instrumentation is touched.
+ */
+static void register_dump()
+{
+    static bool registered = (std::atexit(dump_instrumentation), true);
+    (void)registered;
+}
+
+Instrument_block::Instrument_block():
+c{}
+{
+    register_dump();
+    Instrument_state& s = get_state();
+    std::lock_guard<std::mutex> l{s.m};
+    s.live.insert(this);
+}
+
+Instrument_block::~Instrument_block()
+{
+    Instrument_state& s = get_state();
+    std::lock_guard<std::mutex> l{s.m};
+    for(int i = 0; i < static_cast<int>(instrument_counter::count); ++i) s.totals[i] += c[i];
+    s.live.erase(this);
+}
+
+thread_local Instrument_block instrument_local;
+
+void instrument_phase(const std::string& name, double sec)
+{
+    register_dump();
+    Instrument_state& s = get_state();
+    std::lock_guard<std::mutex> l{s.m};
+    auto& p = s.phases[name];
+    p.first += sec;
+    ++p.second;
+}
+
+void instrument_value(const std::string& name, double v)
+{
+    register_dump();
+    Instrument_state& s = get_state();
+    std::lock_guard<std::mutex> l{s.m};
+    s.values[name] = v;
+}
+
+#endif //RADIOSITY_INSTRUMENT
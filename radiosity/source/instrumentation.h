@@ -0,0 +1,78 @@
+/* date = October 20th 2026 6:40 pm */
+
+/* 
+Instrumentation
+referenced by: class Quad_manager, class Stimuli, class Radiosity, class Projector
+Wall time of the pipeline phases plus work counters, written as JSON to "instrumentation.json" at exit:
+
+{"phases":{"calc_ff":{"seconds":...,"calls":...}, ...},
+ "counters":{"rays_cast":...,"ray_hits":...,"ray_misses":...,"quads_tested":...,"gs_sweeps":...},
+ "values":{"residual_r":..., ...}}
+
+Only built with RADIOSITY_INSTRUMENT defined (build.bat: the debug build and the optimized bin\instrumented 
+build, time phases with the latter), otherwise every INSTRUMENT_ macro expands to nothing 
+and no code, data or atexit work is left. 
+Counters are hot, each thread adds into its own thread_local block, blocks are summed when dumped 
+and folded into the totals when their thread exits. Phases and values are coarse and take a mutex.
+
+INSTRUMENT_SCOPE(name): Times the enclosing scope into phase name, name is a string literal or std::string.
+INSTRUMENT_RAY(hit, tested): One ray cast, whether it hit and how many quads it was tested against.
+INSTRUMENT_COUNT(c, n): Adds n to instrument_counter::c.
+INSTRUMENT_VALUE(name, v): Records the last value of name.
+ */
+
+#ifndef INSTRUMENTATION_H
+#define INSTRUMENTATION_H
+
+#if defined(RADIOSITY_INSTRUMENT)
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <chrono>
+
+enum class instrument_counter : int {rays_cast=0,ray_hits=1,ray_misses=2,quads_tested=3,gs_sweeps=4,count=5};
+
+struct Instrument_block{
+    Instrument_block();
+    ~Instrument_block();
+    uint64_t c[static_cast<int>(instrument_counter::count)];
+};
+
+extern thread_local Instrument_block instrument_local;
+
+inline void instrument_add(instrument_counter c, uint64_t n){instrument_local.c[static_cast<int>(c)] += n;}
+void instrument_phase(const std::string& name, double s);
+void instrument_value(const std::string& name, double v);
+
+class Instrument_timer{
+    public:
+    Instrument_timer(std::string name_):name{std::move(name_)},t0{std::chrono::steady_clock::now()}{}
+    ~Instrument_timer(){instrument_phase(name, std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count());}
+    private:
+    std::string name;
+    std::chrono::steady_clock::time_point t0;
+};
+
+#define INSTRUMENT_CAT_(a, b) a##b
+#define INSTRUMENT_CAT(a, b) INSTRUMENT_CAT_(a, b)
+#define INSTRUMENT_SCOPE(name) Instrument_timer INSTRUMENT_CAT(instrument_scope_, __LINE__){name}
+#define INSTRUMENT_RAY(hit, tested) \
+do{ \
+    instrument_add(instrument_counter::rays_cast, 1); \
+    instrument_add((hit) ? instrument_counter::ray_hits : instrument_counter::ray_misses, 1); \
+    instrument_add(instrument_counter::quads_tested, (tested)); \
+}while(0)
+#define INSTRUMENT_COUNT(c, n) instrument_add(instrument_counter::c, (n))
+#define INSTRUMENT_VALUE(name, v) instrument_value((name), (v))
+
+#else
+
+#define INSTRUMENT_SCOPE(name)
+#define INSTRUMENT_RAY(hit, tested) do{}while(0)
+#define INSTRUMENT_COUNT(c, n) do{}while(0)
+#define INSTRUMENT_VALUE(name, v) do{}while(0)
+
+#endif //RADIOSITY_INSTRUMENT
+
+#endif //INSTRUMENTATION_H
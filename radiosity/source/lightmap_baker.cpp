@@ -0,0 +1,181 @@
+#include "lightmap_baker.h"
+#include <iostream>
+#include <fstream>
+#include <algorithm>
+#include <cmath>
+
+/* 
+Lightmap_baker constructor
+Description:
+Constructs a baker.
+
+Parameters: 
+int d_: Texels per element side, at least 1.
+
+Output: -
+ */
+Lightmap_baker::Lightmap_baker(int d_):
+d{std::max(1, d_)},
+w{0},
+h{0},
+blocks{},
+texels{},
+pool{}
+{}
+
+/* 
+void Lightmap_baker::pack(const std::vector<Face_grid>& grids)
+Description:
+Shelf packs one chart per Face, tallest charts first, into an atlas as wide as the widest chart or 
+the next power of two over the square root of the total area, whichever is bigger. 
+Fills blocks with the top-left gutter texel of every element and sets the atlas size.
+
+Parameters: 
+const std::vector<Face_grid>& grids: Element layout of every Face.
+
+Output: -
+ */
+void Lightmap_baker::pack(const std::vector<Face_grid>& grids)
+{
+    int bs = d + 2;
+    size_t area = 0;
+    int max_cw = 0;
+    std::vector<size_t> order(grids.size());
+    for(size_t i = 0; i < grids.size(); ++i){
+        order[i] = i;
+        area += grids[i].cc*bs * grids[i].rc*bs;
+        max_cw = std::max(max_cw, static_cast<int>(grids[i].cc)*bs);
+    }
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b){return grids[a].rc > grids[b].rc;});
+    
+    w = 1;
+    while(w < max_cw || size_t(w)*size_t(w) < area) w *= 2;
+    
+    blocks.clear();
+    int x = 0;
+    int y = 0;
+    int sh = 0;
+    for(size_t gi:order){
+        const Face_grid& g = grids[gi];
+        int cw = static_cast<int>(g.cc)*bs;
+        int ch = static_cast<int>(g.rc)*bs;
+        if(x + cw > w)
+        {
+            y += sh;
+            x = 0;
+            sh = 0;
+        }
+        for(size_t i = 0; i < g.rc; ++i){
+            for(size_t j = 0; j < g.cc; ++j){
+                blocks.push_back({static_cast<ElemIndex>(g.si + i*g.cc + j), x + static_cast<int>(j)*bs, y + static_cast<int>(i)*bs});
+            }
+        }
+        x += cw;
+        sh = std::max(sh, ch);
+    }
+    h = y + sh;
+}
+
+/* 
+bool Lightmap_baker::bake(const Displayable& dp, std::string name)
+Description:
+Packs the atlas, fills every element block in parallel from its Quad and writes <name>.pfm and <name>.uv.
+
+Parameters: 
+const Displayable& dp: Solved displayable.
+std::string name: Output file name without extension.
+
+Output:
+bool: Whether both files were written.
+ */
+bool Lightmap_baker::bake(const Displayable& dp, std::string name)
+{
+    const auto& quads = dp.request_quads();
+    pack(dp.request_face_grids());
+    texels.assign(size_t(w)*size_t(h)*3, 0.0f);
+    
+    int bs = d + 2;
+    pool.parallel_for(blocks.size(), [&](size_t bi){
+        const Block& b = blocks[bi];
+        Quad& q = *quads[b.i];
+        for(int by = 0; by < bs; ++by){
+            // NOTE(Alex): Gutter texels repeat the closest inner texel
+            int tv = std::min(d - 1, std::max(0, by - 1));
+            float v = (static_cast<float>(tv) + 0.5f) / static_cast<float>(d);
+            float* row = texels.data() + (size_t(b.y + by)*size_t(w) + size_t(b.x))*3;
+            for(int bx = 0; bx < bs; ++bx){
+                int tu = std::min(d - 1, std::max(0, bx - 1));
+                float u = (static_cast<float>(tu) + 0.5f) / static_cast<float>(d);
+                Color<float> c = q.get_radiance(u, v);
+                row[bx*3 + 0] = c.r;
+                row[bx*3 + 1] = c.g;
+                row[bx*3 + 2] = c.b;
+            }
+        }
+    });
+    
+    bool ok = write_pfm(name + ".pfm");
+    return write_uv(name + ".uv", quads) && ok;
+}
+
+/* 
+bool Lightmap_baker::write_pfm(std::string fn)const
+Description:
+Writes the atlas as a little-endian color PFM, PFM scanlines go bottom to top.
+
+Parameters: 
+std::string fn: FileName.
+
+Output:
+bool: Whether the file was written.
+ */
+bool Lightmap_baker::write_pfm(std::string fn)const
+{
+    std::ofstream ofs(fn, std::ios::trunc | std::ios::out | std::ios::binary);
+    if(!ofs.is_open())
+    {
+        std::cout << "Unable to open file:" << fn << std::endl;
+        return false;
+    }
+    ofs << "PF\n" << w << " " << h << "\n-1.0\n";
+    for(int r = h - 1; r >= 0; --r){
+        ofs.write(reinterpret_cast<const char*>(texels.data() + size_t(r)*size_t(w)*3), std::streamsize(size_t(w)*3*sizeof(float)));
+    }
+    return bool(ofs);
+}
+
+/* 
+bool Lightmap_baker::write_uv(std::string fn, const std::vector<std::shared_ptr<Quad>>& quads)const
+Description:
+Writes the element to atlas mapping, see lightmap_baker.h for the format.
+
+Parameters: 
+std::string fn: FileName.
+const std::vector<std::shared_ptr<Quad>>& quads: Quads indexed by element index.
+
+Output:
+bool: Whether the file was written.
+ */
+bool Lightmap_baker::write_uv(std::string fn, const std::vector<std::shared_ptr<Quad>>& quads)const
+{
+    std::ofstream ofs(fn, std::ios::trunc | std::ios::out);
+    if(!ofs.is_open())
+    {
+        std::cout << "Unable to open file:" << fn << std::endl;
+        return false;
+    }
+    auto put = [&](const Vec3<float>& p){ofs << " " << p.x << " " << p.y << " " << p.z;};
+    ofs << "lightmap " << w << " " << h << " " << d << "\n";
+    for(const Block& b:blocks){
+        const Quad& q = *quads[b.i];
+        ofs << b.i
+            << " " << float(b.x + 1) / float(w) << " " << float(b.y + 1) / float(h)
+            << " " << float(b.x + 1 + d) / float(w) << " " << float(b.y + 1 + d) / float(h);
+        put(q.get_point(0,0));
+        put(q.get_point(1,0));
+        put(q.get_point(0,1));
+        put(q.get_point(1,1));
+        ofs << "\n";
+    }
+    return bool(ofs);
+}
@@ -0,0 +1,51 @@
+/* date = October 19th 2026 10:05 pm */
+
+/* 
+class Lightmap_baker
+Bakes the solved radiosity into a texture atlas for real-time engines.
+
+Every Face becomes one chart, a grid with one d x d texel block per element (d texels per element), 
+each block wrapped in a 1 texel gutter that repeats its border so bilinear filtering never bleeds 
+between elements. Charts are shelf packed, tallest first, into one atlas.
+Texels hold the bilinearly interpolated vertex radiance (Quad::c) at their centers, unclipped.
+
+Output:
+-<name>.pfm: Float RGB atlas.
+-<name>.uv: Text mapping, "lightmap <width> <height> <d>" then one line per element:
+ "<element index> <u0> <v0> <u1> <v1> <p00> <p10> <p01> <p11>", the atlas rectangle in [0,1] UVs 
+ (origin at the top-left texel, v grows downwards) and the World-Space corners at quad hit coordinates 
+ (0,0) (1,0) (0,1) (1,1), which map to (u0,v0) (u1,v0) (u0,v1) (u1,v1).
+ */
+
+#ifndef LIGHTMAP_BAKER_H
+#define LIGHTMAP_BAKER_H
+
+#include <string>
+#include <vector>
+#include "displayable.h"
+#include "thread_pool.h"
+
+class Lightmap_baker{
+    public:
+    Lightmap_baker(int d_ = 4);
+    bool bake(const Displayable& dp, std::string name);
+    int get_width()const{return w;}
+    int get_height()const{return h;}
+    private:
+    struct Block{
+        ElemIndex i;
+        int x;
+        int y;
+    };
+    void pack(const std::vector<Face_grid>& grids);
+    bool write_pfm(std::string fn)const;
+    bool write_uv(std::string fn, const std::vector<std::shared_ptr<Quad>>& quads)const;
+    int d;
+    int w;
+    int h;
+    std::vector<Block> blocks;
+    std::vector<float> texels;
+    Thread_pool pool;
+};
+
+#endif //LIGHTMAP_BAKER_H
@@ -7,6 +7,15 @@ Radiosity Solver by Alejandro Armenta
 #include "space.h"
 #include "ortho_projector.h"
 #include "persp_projector.h"
+#include "preview_renderer.h"
+#include "render_daemon.h"
+#include "lightmap_baker.h"
+#include "mem_accounting.h"
+#include "convergence_log.h"
+#include <memory>
+#include <string>
+#include <cstdlib>
+#include <iostream>
 
 #if defined(_MSC_VER)
 #define _CRTDBG_MAP_ALLOC
@@ -16,19 +25,112 @@ Radiosity Solver by Alejandro Armenta
 // allocations to be of _CLIENT_BLOCK type
 #endif
 
-float fw=10.0f;
-int hps=10;
-Space space{fw,hps};
+static void print_usage()
+{
+    std::cout << "usage: main [--hps <elements per face side>] [--daemon] [--memory-budget <MiB>]" 
+        << " [--ff-format f32|q16|q8|hmat] [--convergence-log <file.csv>] [--threads <count>] [--nondeterministic]"
+        << " [--bake-lightmap <name> [--texels <per element side>]]" << std::endl;
+}
+
+static const char* ff_format_names[]{"f32", "q16", "q8", "hmat"};
+
+static bool parse_ff_format(const std::string& s, ff_format& fmt)
+{
+    for(int i = 0; i < 4; ++i){
+        if(s == ff_format_names[i])
+        {
+            fmt = static_cast<ff_format>(i);
+            return true;
+        }
+    }
+    return false;
+}
 
-int main()
+int main(int argc, char** argv)
 {
 #if defined(_MSC_VER)
     _CrtSetDbgFlag( _CRTDBG_ALLOC_MEM_DF | _CRTDBG_LEAK_CHECK_DF );
 	//_CrtSetBreakAlloc(147);	
 #endif
     
-    OrthoProjector o{};
-    o.render(fw,fw,1024,1024);
-    PerspectiveProjector p{};
-    p.render(fw,fw,1024,1024);
-}
\ No newline at end of file
+    float fw=10.0f;
+    int hps=10;
+    bool daemon=false;
+    ff_format fmt=ff_format::f32;
+    std::string log_path;
+    int threads=0;
+    bool deterministic=true;
+    std::string lightmap;
+    int texels=4;
+    for(int i = 1; i < argc; ++i){
+        std::string a{argv[i]};
+        if(a == "--daemon") daemon = true;
+        else if(a == "--hps" && i + 1 < argc) hps = std::atoi(argv[++i]);
+        else if(a == "--memory-budget" && i + 1 < argc) mem_set_budget(size_t(std::atoll(argv[++i])) << 20);
+        else if(a == "--ff-format" && i + 1 < argc && parse_ff_format(argv[i + 1], fmt)) ++i;
+        else if(a == "--convergence-log" && i + 1 < argc) log_path = argv[++i];
+        else if(a == "--threads" && i + 1 < argc) threads = std::atoi(argv[++i]);
+        else if(a == "--nondeterministic") deterministic = false;
+        else if(a == "--bake-lightmap" && i + 1 < argc) lightmap = argv[++i];
+        else if(a == "--texels" && i + 1 < argc) texels = std::atoi(argv[++i]);
+        else
+        {
+            print_usage();
+            return 1;
+        }
+    }
+    if(hps < 1 || threads < 0 || texels < 1)
+    {
+        print_usage();
+        return 1;
+    }
+    
+    Preview_renderer preview{get_persp_camera(fw,fw), 128, 128, "Preview"};
+    Space space{fw,hps,fmt,&preview};
+    // NOTE(Alex): --threads 0 (the default) uses every hardware thread for F, the residuals and the render
+    space.set_threads(size_t(threads));
+    space.set_deterministic(deterministic);
+    std::unique_ptr<Convergence_log> log;
+    if(!log_path.empty())
+    {
+        log = std::make_unique<Convergence_log>(log_path, ff_format_names[static_cast<int>(fmt)]);
+        if(!log->is_open()) return 1;
+        space.add_observer(log.get());
+    }
+    
+    // NOTE(Alex): --daemon keeps the solved space resident and renders requests from stdin, see render_daemon.h
+    if(daemon)
+    {
+        // NOTE(Alex): Answers own stdout, every diagnostic printed to std::cout (phases, Canvas, preview, report) goes to stderr
+        std::ostream answers{std::cout.rdbuf()};
+        std::streambuf* cout_buf = std::cout.rdbuf(std::cerr.rdbuf());
+        int res = 1;
+        if(space.solve())
+        {
+            Render_daemon rd{space, fw, fw};
+            res = rd.serve(std::cin, answers);
+            mem_print_report();
+        }
+        std::cout.rdbuf(cout_buf);
+        return res;
+    }
+    
+    // NOTE(Alex): --bake-lightmap writes <name>.pfm and <name>.uv instead of rendering, see lightmap_baker.h
+    if(!lightmap.empty())
+    {
+        if(!space.solve()) return 1;
+        Lightmap_baker lb{texels};
+        bool baked = lb.bake(space, lightmap);
+        if(baked) std::cout << "Lightmap " << lightmap << ": " << lb.get_width() << " x " << lb.get_height() << std::endl;
+        mem_print_report();
+        return baked ? 0 : 1;
+    }
+    
+    // NOTE(Alex): Every view in one batch, tiles of all of them share the pool
+    std::vector<Camera> cams = get_ortho_cameras(fw,fw);
+    cams.push_back(get_persp_camera(fw,fw));
+    Projector p{size_t(threads)};
+    bool ok = space.render(p, cams, 1024, 1024);
+    mem_print_report();
+    return ok ? 0 : 1;
+}
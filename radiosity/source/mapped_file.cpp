@@ -0,0 +1,226 @@
+#include "mapped_file.h"
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cstdlib>
+#endif
+
+/* 
+Mapped_file Destructor
+Description:
+Unmaps the view and releases file handles.
+
+Parameters: 
+
+Output: -
+ */
+Mapped_file::~Mapped_file(){
+    close();
+}
+
+/* 
+bool Mapped_file::open_read(const std::string& fn)
+Description:
+Maps an existing file read-only.
+
+Parameters: 
+const std::string& fn: FileName.
+
+Output:
+bool: Whether the whole file got mapped, empty files are never mapped.
+ */
+bool Mapped_file::open_read(const std::string& fn){
+    close();
+#if defined(_WIN32)
+    HANDLE f = CreateFileA(fn.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if(f == INVALID_HANDLE_VALUE) return false;
+    LARGE_INTEGER fs{};
+    if(!GetFileSizeEx(f, &fs) || fs.QuadPart == 0){CloseHandle(f); return false;}
+    HANDLE m = CreateFileMappingA(f, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if(!m){CloseHandle(f); return false;}
+    d = MapViewOfFile(m, FILE_MAP_READ, 0, 0, 0);
+    if(!d){CloseHandle(m); CloseHandle(f); return false;}
+    fh = f;
+    mh = m;
+    s = static_cast<size_t>(fs.QuadPart);
+#else
+    fd = ::open(fn.c_str(), O_RDONLY);
+    if(fd < 0) return false;
+    struct stat st{};
+    if(fstat(fd, &st) != 0 || st.st_size == 0){close(); return false;}
+    void* p = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    if(p == MAP_FAILED){close(); return false;}
+    d = p;
+    s = static_cast<size_t>(st.st_size);
+#endif
+    return true;
+}
+
+/* 
+bool Mapped_file::create(const std::string& fn, size_t s_)
+Description:
+Creates (or truncates) a file of s_ bytes and maps it read-write.
+
+Parameters: 
+const std::string& fn: FileName.
+size_t s_: File size in bytes.
+
+Output:
+bool: Whether the file got created and mapped.
+ */
+bool Mapped_file::create(const std::string& fn, size_t s_){
+    close();
+    if(s_ == 0) return false;
+#if defined(_WIN32)
+    HANDLE f = CreateFileA(fn.c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if(f == INVALID_HANDLE_VALUE) return false;
+    LARGE_INTEGER fs{};
+    fs.QuadPart = static_cast<LONGLONG>(s_);
+    HANDLE m = CreateFileMappingA(f, nullptr, PAGE_READWRITE, fs.HighPart, fs.LowPart, nullptr);
+    if(!m){CloseHandle(f); return false;}
+    d = MapViewOfFile(m, FILE_MAP_ALL_ACCESS, 0, 0, 0);
+    if(!d){CloseHandle(m); CloseHandle(f); return false;}
+    fh = f;
+    mh = m;
+#else
+    fd = ::open(fn.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if(fd < 0) return false;
+    if(ftruncate(fd, static_cast<off_t>(s_)) != 0){close(); return false;}
+    void* p = mmap(nullptr, s_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if(p == MAP_FAILED){close(); return false;}
+    d = p;
+#endif
+    s = s_;
+    return true;
+}
+
+/* 
+bool Mapped_file::create_temporary(size_t s_)
+Description:
+Creates a uniquely named scratch file of s_ bytes in the working directory and maps it read-write. 
+The file is deleted by the OS when the mapping gets closed, even if the process dies.
+
+Parameters: 
+size_t s_: File size in bytes.
+
+Output:
+bool: Whether the file got created and mapped.
+ */
+bool Mapped_file::create_temporary(size_t s_){
+    close();
+    if(s_ == 0) return false;
+#if defined(_WIN32)
+    char fn[MAX_PATH];
+    if(!GetTempFileNameA(".", "rad", 0, fn)) return false;
+    HANDLE f = CreateFileA(fn, GENERIC_READ | GENERIC_WRITE, FILE_SHARE_DELETE, nullptr, CREATE_ALWAYS, 
+                           FILE_ATTRIBUTE_TEMPORARY | FILE_FLAG_DELETE_ON_CLOSE, nullptr);
+    if(f == INVALID_HANDLE_VALUE) return false;
+    LARGE_INTEGER fs{};
+    fs.QuadPart = static_cast<LONGLONG>(s_);
+    HANDLE m = CreateFileMappingA(f, nullptr, PAGE_READWRITE, fs.HighPart, fs.LowPart, nullptr);
+    if(!m){CloseHandle(f); return false;}
+    d = MapViewOfFile(m, FILE_MAP_ALL_ACCESS, 0, 0, 0);
+    if(!d){CloseHandle(m); CloseHandle(f); return false;}
+    fh = f;
+    mh = m;
+#else
+    char fn[] = "./radiosity_XXXXXX";
+    fd = mkstemp(fn);
+    if(fd < 0) return false;
+    unlink(fn);
+    if(ftruncate(fd, static_cast<off_t>(s_)) != 0){close(); return false;}
+    void* p = mmap(nullptr, s_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if(p == MAP_FAILED){close(); return false;}
+    d = p;
+#endif
+    s = s_;
+    return true;
+}
+
+/* 
+void Mapped_file::advise_sequential()const
+Description:
+Hints the OS that the mapping is about to be walked front to back, so it reads ahead aggressively. 
+No-op on Windows, the only call there is PrefetchVirtualMemory, which reads the whole range in rather 
+than hinting, for a mapping larger than RAM every pass would page in all of it.
+
+Parameters: 
+
+Output: -
+ */
+void Mapped_file::advise_sequential()const{
+    if(!d) return;
+#if !defined(_WIN32)
+    madvise(d, s, MADV_SEQUENTIAL);
+#endif
+}
+
+/* 
+void Mapped_file::release(size_t o, size_t l)const
+Description:
+Writes back and drops the resident pages of byte range [o,o+l) once the caller is done with it, 
+this is what bounds resident memory while streaming through a mapping larger than RAM. 
+Only whole pages inside the range are released.
+
+Parameters: 
+size_t o: Byte offset into the mapping.
+size_t l: Byte length.
+
+Output: -
+ */
+void Mapped_file::release(size_t o, size_t l)const{
+    if(!d || o >= s) return;
+    if(l > s - o) l = s - o;
+#if defined(_WIN32)
+    SYSTEM_INFO si{};
+    GetSystemInfo(&si);
+    size_t ps = si.dwPageSize;
+#else
+    size_t ps = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+#endif
+    size_t b = (o + ps - 1) / ps * ps;
+    size_t e = (o + l) / ps * ps;
+    if(o + l == s) e = s;
+    if(e <= b) return;
+    char* p = static_cast<char*>(d) + b;
+#if defined(_WIN32)
+    FlushViewOfFile(p, e - b);
+    // NOTE(Alex): Unlocking pages that are not locked trims them from the working set
+    VirtualUnlock(p, e - b);
+#else
+    msync(p, e - b, MS_ASYNC);
+    madvise(p, e - b, MADV_DONTNEED);
+#endif
+}
+
+/* 
+void Mapped_file::close()
+Description:
+Unmaps the view, changes to read-write mappings are written back by the OS.
+
+Parameters: 
+
+Output: -
+ */
+void Mapped_file::close(){
+#if defined(_WIN32)
+    if(d) UnmapViewOfFile(d);
+    if(mh) CloseHandle(mh);
+    if(fh) CloseHandle(fh);
+    mh = nullptr;
+    fh = nullptr;
+#else
+    if(d) munmap(d, s);
+    if(fd >= 0) ::close(fd);
+    fd = -1;
+#endif
+    d = nullptr;
+    s = 0;
+}
@@ -0,0 +1,47 @@
+/* date = October 19th 2026 9:12 am */
+
+/* 
+class Mapped_file
+referenced by: class Solution_cache, class Matrix_storage
+Memory mapping of a whole file, either read-only for an existing file or read-write for a 
+file created with a given size. Wraps mmap on POSIX and MapViewOfFile on Windows.
+Temporary files live in the working directory and are deleted once unmapped.
+ */
+
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <string>
+
+class Mapped_file{
+    public:
+    Mapped_file()=default;
+    ~Mapped_file();
+    
+    Mapped_file(const Mapped_file&)=delete;
+    Mapped_file& operator=(const Mapped_file&)=delete;
+    
+    bool open_read(const std::string& fn);
+    bool create(const std::string& fn, size_t s);
+    bool create_temporary(size_t s);
+    void close();
+    
+    void advise_sequential()const;
+    void release(size_t o, size_t l)const;
+    
+    void* get_data()const{return d;}
+    size_t get_size()const{return s;}
+    bool is_open()const{return d != nullptr;}
+    
+    private:
+    void* d{};
+    size_t s{};
+#if defined(_WIN32)
+    void* fh{};
+    void* mh{};
+#else
+    int fd{-1};
+#endif
+};
+
+#endif //MAPPED_FILE_H
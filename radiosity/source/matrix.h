@@ -11,6 +11,10 @@
 #include <fstream>
 #include <ios>
 #include <cassert>
+#include <memory>
+#include <algorithm>
+#include "mapped_file.h"
+#include "mem_accounting.h"
 
 
 template<typename T>
@@ -20,6 +24,99 @@ class Matrix_2d;
 I want the data as Rows!!!
  */
 
+/* 
+Matrix_storage
+referenced by: class Matrix<T,2>
+Element storage of a Matrix, either in memory or backed by a memory-mapped scratch file for 
+matrices that do not fit in RAM. Copies always land in memory.
+Its bytes are accounted as matrix or mapped_matrix, see mem_accounting.h.
+ */
+template<typename T>
+class Matrix_storage{
+    public:
+    Matrix_storage():
+    elem{},
+    mf{},
+    base{},
+    s{},
+    acc{}
+    {}
+    
+    Matrix_storage(const size_t n, const bool mapped = false):
+    elem{},
+    mf{},
+    base{},
+    s{n},
+    acc{}
+    {
+        if(mapped)
+        {
+            mf = std::make_unique<Mapped_file>();
+            if(mf->create_temporary(n*sizeof(T))) base = static_cast<T*>(mf->get_data());
+            else
+            {
+                std::cout << "Unable to map matrix storage, falling back to memory" << std::endl;
+                mf.reset();
+            }
+        }
+        if(!base)
+        {
+            elem.resize(n);
+            base = elem.data();
+        }
+        acc.set(mf ? mem_category::mapped_matrix : mem_category::matrix, n*sizeof(T));
+    }
+    
+    Matrix_storage(const Matrix_storage& o):
+    elem(o.begin(), o.end()),
+    mf{},
+    base{elem.data()},
+    s{o.s},
+    acc{mem_category::matrix, o.s*sizeof(T)}
+    {}
+    
+    Matrix_storage(Matrix_storage&& o)noexcept:
+    elem{std::move(o.elem)},
+    mf{std::move(o.mf)},
+    base{o.base},
+    s{o.s},
+    acc{std::move(o.acc)}
+    {
+        o.base = nullptr;
+        o.s = 0;
+    }
+    
+    Matrix_storage& operator=(Matrix_storage o){
+        std::swap(elem, o.elem);
+        std::swap(mf, o.mf);
+        std::swap(base, o.base);
+        std::swap(s, o.s);
+        std::swap(acc, o.acc);
+        return *this;
+    }
+    
+    T& operator[](const size_t i){return base[i];}
+    const T& operator[](const size_t i)const{return base[i];}
+    T* begin(){return base;}
+    T* end(){return base + s;}
+    const T* begin()const{return base;}
+    const T* end()const{return base + s;}
+    T* data(){return base;}
+    const T* data()const{return base;}
+    size_t size()const{return s;}
+    bool is_mapped()const{return mf != nullptr;}
+    
+    void advise_sequential()const{if(mf) mf->advise_sequential();}
+    void release(const size_t i, const size_t n)const{if(mf) mf->release(i*sizeof(T), n*sizeof(T));}
+    
+    private:
+    std::vector<T> elem;
+    std::unique_ptr<Mapped_file> mf;
+    T* base;
+    size_t s;
+    Mem_account acc;
+};
+
 /* 
 Matrix_desc
 N>2 not defined
@@ -88,9 +185,9 @@ class Matrix<T,2>{
     elem{}
     {}
     
-    Matrix(const size_t i, const size_t j):
+    Matrix(const size_t i, const size_t j, const bool mapped = false):
     desc{i,j},
-    elem(desc.size())
+    elem(desc.size(), mapped)
     {}
     
     //Matrix(const Matrix& o);
@@ -98,6 +195,13 @@ class Matrix<T,2>{
     T& operator()(const size_t row_i, const size_t col_i);
     const T& operator()(const size_t row_i, const size_t col_i)const;
     size_t get_extent(size_t i)const{return desc.extent(i);}
+    T* data(){return elem.data();}
+    const T* data()const{return elem.data();}
+    
+    bool is_mapped()const{return elem.is_mapped();}
+    size_t get_block_rows()const;
+    void advise_sequential()const{elem.advise_sequential();}
+    void release_rows(const size_t row_i, const size_t row_c)const{elem.release(desc(row_i,0), row_c*get_extent(1));}
     
     Matrix& operator-=(const Matrix&);
     
@@ -107,7 +211,7 @@ class Matrix<T,2>{
     
     private:
     Matrix_desc<2> desc;
-    std::vector<T> elem;
+    Matrix_storage<T> elem;
 };
 
 template<typename T>
@@ -130,6 +234,17 @@ Matrix<T,2>& Matrix<T,2>::operator-=(const Matrix<T,2>& o){
     return *this;
 }
 
+/* 
+Rows per streaming block, row-block loops release each block once done with it so 
+mapped matrices keep a bounded resident footprint.
+ */
+template<typename T>
+size_t Matrix<T,2>::get_block_rows()const{
+    const size_t block_bytes = size_t(8) << 20;
+    size_t row_bytes = std::max<size_t>(1, get_extent(1)*sizeof(T));
+    return std::max<size_t>(1, block_bytes / row_bytes);
+}
+
 template<typename T>
 Matrix<T,2>& Matrix<T,2>::make_diagonal(const Matrix<T,1>& o){
     assert(o.get_extent() == get_extent(0) &&
@@ -179,6 +294,8 @@ Matrix<T,2> sub_m(const Matrix<T,2>& m1,const Matrix<T,2>& m2){
 
 template<typename T>
 void num_solver_gs(const Matrix<T,2>& a, Matrix<T,1>& x,const Matrix<T,1>& b){
+    size_t br=a.get_block_rows();
+    a.advise_sequential();
     for(size_t i=0;i<a.get_extent(0);++i){
         T s{};
         T ic{1.0f/a(i,i)};
@@ -188,7 +305,9 @@ void num_solver_gs(const Matrix<T,2>& a, Matrix<T,1>& x,const Matrix<T,1>& b){
         }
         s=-s;
         x(i)=(b(i)+s)*ic;
+        if((i+1)%br==0)a.release_rows(i+1-br,br);
     }
+    a.release_rows(0,a.get_extent(0));
 }
 
 
@@ -257,17 +376,21 @@ class Matrix<T,1>{
     
     Matrix():
     desc{},
-    elem{}
+    elem{},
+    acc{}
     {}
     
     Matrix(const size_t i):
     desc{i},
-    elem(desc.size())
+    elem(desc.size()),
+    acc{mem_category::matrix, desc.size()*sizeof(T)}
     {}
     
     T& operator()(const size_t n);
     const T& operator()(const size_t n)const;
     size_t get_extent()const{return desc.extent();}
+    T* data(){return elem.data();}
+    const T* data()const{return elem.data();}
     
     Matrix& operator-=(const Matrix&);
     
@@ -276,6 +399,8 @@ class Matrix<T,1>{
     private:
     Matrix_desc<1> desc;
     std::vector<T> elem;
+    // NOTE(Alex): Copies add their bytes, moves hand them over, same as elem
+    Mem_account acc;
 };
 
 
@@ -309,11 +434,15 @@ template<typename T>
 Matrix<T,1> mult_m(const Matrix<T,2>& m1,const Matrix<T,1>& m2){
     assert(m1.get_extent(1)==m2.get_extent());
     Matrix<T,1> res(m1.get_extent(0));
+    size_t br=m1.get_block_rows();
+    m1.advise_sequential();
     for(auto i=0;i<m1.get_extent(0);++i){
         for(auto j=0;j<m2.get_extent();++j){
             res(i) += m1(i,j)*m2(j);
         }
+        if((i+1)%br==0)m1.release_rows(i+1-br,br);
     }
+    m1.release_rows(0,m1.get_extent(0));
     return res;
 }
 
@@ -0,0 +1,70 @@
+#include "mem_accounting.h"
+#include <atomic>
+#include <iostream>
+
+static const char* category_names[]{"matrix", "mapped_matrix", "elements", "framebuffer"};
+
+static std::atomic<size_t> current[static_cast<int>(mem_category::count)]{};
+static std::atomic<size_t> peak[static_cast<int>(mem_category::count)]{};
+static std::atomic<size_t> budget{0};
+
+void mem_add(mem_category c, size_t bytes)
+{
+    if(!bytes) return;
+    int i = static_cast<int>(c);
+    size_t now = current[i].fetch_add(bytes, std::memory_order_relaxed) + bytes;
+    size_t p = peak[i].load(std::memory_order_relaxed);
+    while(now > p && !peak[i].compare_exchange_weak(p, now, std::memory_order_relaxed)){}
+}
+
+void mem_sub(mem_category c, size_t bytes)
+{
+    if(!bytes) return;
+    current[static_cast<int>(c)].fetch_sub(bytes, std::memory_order_relaxed);
+}
+
+size_t mem_get_current(mem_category c){return current[static_cast<int>(c)].load(std::memory_order_relaxed);}
+size_t mem_get_peak(mem_category c){return peak[static_cast<int>(c)].load(std::memory_order_relaxed);}
+void mem_set_budget(size_t bytes){budget.store(bytes, std::memory_order_relaxed);}
+size_t mem_get_budget(){return budget.load(std::memory_order_relaxed);}
+
+/* 
+void mem_print_report()
+Description:
+Prints current and peak bytes of every category. 
+NOTE: The total peak is the sum of per-category peaks, an upper bound of the real peak.
+
+Parameters: 
+
+Output: -
+ */
+void mem_print_report()
+{
+    size_t tc = 0;
+    size_t tp = 0;
+    std::cout << "Memory (current / peak bytes):" << std::endl;
+    for(int i = 0; i < static_cast<int>(mem_category::count); ++i){
+        size_t c = current[i].load(std::memory_order_relaxed);
+        size_t p = peak[i].load(std::memory_order_relaxed);
+        tc += c;
+        tp += p;
+        std::cout << " " << category_names[i] << ": " << c << " / " << p << std::endl;
+    }
+    std::cout << " total: " << tc << " / " << tp << std::endl;
+}
+
+/* 
+void mem_reset_peaks()
+Description:
+Sets the peak of every category to its current bytes.
+
+Parameters: 
+
+Output: -
+ */
+void mem_reset_peaks()
+{
+    for(int i = 0; i < static_cast<int>(mem_category::count); ++i){
+        peak[i].store(current[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+}
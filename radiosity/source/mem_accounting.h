@@ -0,0 +1,73 @@
+/* date = October 21st 2026 10:10 am */
+
+/* 
+Memory accounting
+referenced by: class Matrix_storage, class Quantized_matrix, class Quad_manager, class Canvas, class RasterProjector, class Radiosity, main.cpp
+Current and peak bytes of the big data structures, per category:
+
+matrix: Matrix storage held in RAM, F, K, the quantized copy of F and the Matrix<T,1> vectors: B, residuals, temporaries of mult_m and friends.
+mapped_matrix: Matrix storage in memory-mapped scratch files, paged by the OS rather than held.
+elements: Quads (Element + Element_impl + HemiCube each), their shared_ptrs and the candidate lists.
+framebuffer: Mapped PPM canvases, float radiance buffers and z-buffers.
+
+Owners hold a Mem_account, which adds its bytes on construction / resize and gives them back on destruction. 
+Counters are atomics, accounts are only touched on allocations, never in per-sample loops.
+
+A memory budget (0 = none, the default) makes Radiosity::mesh warn before meshing when the 
+estimated footprint of the requested hps does not fit, see Radiosity::estimate_bytes.
+mem_reset_peaks drops peaks to the current bytes, so the peak of a single phase can be read after it.
+ */
+
+#ifndef MEM_ACCOUNTING_H
+#define MEM_ACCOUNTING_H
+
+#include <cstddef>
+
+enum class mem_category : int {matrix=0,mapped_matrix=1,elements=2,framebuffer=3,count=4};
+
+void mem_add(mem_category c, size_t bytes);
+void mem_sub(mem_category c, size_t bytes);
+size_t mem_get_current(mem_category c);
+size_t mem_get_peak(mem_category c);
+void mem_set_budget(size_t bytes);
+size_t mem_get_budget();
+void mem_print_report();
+void mem_reset_peaks();
+
+class Mem_account{
+    public:
+    Mem_account(mem_category c_ = mem_category::matrix, size_t bytes_ = 0):c{c_},bytes{bytes_}{mem_add(c, bytes);}
+    ~Mem_account(){mem_sub(c, bytes);}
+    Mem_account(const Mem_account& o):c{o.c},bytes{o.bytes}{mem_add(c, bytes);}
+    Mem_account(Mem_account&& o)noexcept:c{o.c},bytes{o.bytes}{o.bytes = 0;}
+    Mem_account& operator=(const Mem_account& o){set(o.c, o.bytes); return *this;}
+    Mem_account& operator=(Mem_account&& o)noexcept
+    {
+        if(this == &o) return *this;
+        mem_sub(c, bytes);
+        c = o.c;
+        bytes = o.bytes;
+        o.bytes = 0;
+        return *this;
+    }
+    void set(mem_category c_, size_t bytes_)
+    {
+        // NOTE(Alex): Only the difference within a category, adding before subtracting would double count every resize in the peak
+        if(c_ == c){
+            if(bytes_ > bytes) mem_add(c, bytes_ - bytes);
+            else mem_sub(c, bytes - bytes_);
+        }else{
+            mem_add(c_, bytes_);
+            mem_sub(c, bytes);
+        }
+        c = c_;
+        bytes = bytes_;
+    }
+    void set(size_t bytes_){set(c, bytes_);}
+    size_t get_bytes()const{return bytes;}
+    private:
+    mem_category c;
+    size_t bytes;
+};
+
+#endif //MEM_ACCOUNTING_H
@@ -15,14 +15,12 @@ support multiple rendering systems.
 #include "ray.h"
 #include "canvas.h"
 #include "projector.h"
-#include "space.h"
-
-extern Space space;
+#include "displayable.h"
 
 class PerspectiveProjector : public Projector
 {
     public:
-    void render(float rfw, float rfh, int th, int tw);
+    void render(Displayable& d, float rfw, float rfh, int th, int tw);
     private:
 };
 
@@ -0,0 +1,150 @@
+#include "preview_renderer.h"
+#include <cfloat>
+#include <iostream>
+#include "quad_manager.h"
+#include "trace.h"
+
+/* 
+Preview_renderer Constructor
+Description:
+Sets the preview camera up, nothing is rendered until a solve starts.
+
+Parameters: 
+const Camera& c_: Preview camera.
+int th: Texels per canvas height.
+int tw: Texels per canvas width.
+std::string name_: Output name, frames are written to "<name>.ppm".
+size_t cadence_: Sweeps between frames.
+
+Output: -
+ */
+Preview_renderer::Preview_renderer(const Camera& c_, int th, int tw, std::string name_, size_t cadence_):
+Solver_observer{cadence_},
+c{c_},
+canvas(c_.X, c_.Y, c_.O, c_.fw, c_.fh, th, tw, c_.cg),
+name{name_},
+ids{},
+pending{},
+fresh{false},
+stop{false},
+frames{0},
+m{},
+cv{},
+t{}
+{
+}
+
+Preview_renderer::~Preview_renderer()
+{
+    on_end();
+}
+
+/* 
+void Preview_renderer::on_begin(const Quad_manager& qm)
+Description:
+Ray casts the element index seen by every sample and starts the drawing thread.
+
+Parameters: 
+const Quad_manager& qm: Meshed scene about to be solved.
+
+Output: -
+ */
+void Preview_renderer::on_begin(const Quad_manager& qm)
+{
+    size_t sc = canvas.get_sample_count();
+    ids.assign(sc, -1);
+    for(size_t k = 0; k < sc; ++k){
+        HitRec rec;
+        Quad* q = qm.closest_hit(c.get_ray(canvas.get_p_sample(k)), 0.001f, FLT_MAX, rec);
+        if(q) ids[k] = q->get_index();
+    }
+    
+    std::lock_guard<std::mutex> l{m};
+    fresh = false;
+    stop = false;
+    if(!t.joinable()) t = std::thread{[this]{draw_frames();}};
+}
+
+/* 
+void Preview_renderer::on_progress(size_t sweep, const Stimuli& r, const Stimuli& g, const Stimuli& b)
+Description:
+Copies the current solution into the pending snapshot, replacing any snapshot not drawn yet.
+
+Parameters: 
+size_t sweep: Sweeps done so far.
+const Stimuli& r: Red stimuli.
+const Stimuli& g: Green stimuli.
+const Stimuli& b: Blue stimuli.
+
+Output: -
+ */
+void Preview_renderer::on_progress(size_t sweep, const Stimuli& r, const Stimuli& g, const Stimuli& b)
+{
+    {
+        std::lock_guard<std::mutex> l{m};
+        size_t n = r.n;
+        pending.sweep = sweep;
+        pending.residual[0] = r.residual_norm;
+        pending.residual[1] = g.residual_norm;
+        pending.residual[2] = b.residual_norm;
+        pending.b.resize(n);
+        for(size_t i = 0; i < n; ++i) pending.b[i] = {r.b(i), g.b(i), b.b(i)};
+        fresh = true;
+    }
+    cv.notify_one();
+}
+
+/* 
+void Preview_renderer::on_end()
+Description:
+Lets the drawing thread finish the last snapshot and joins it.
+
+Parameters: 
+
+Output: -
+ */
+void Preview_renderer::on_end()
+{
+    {
+        std::lock_guard<std::mutex> l{m};
+        stop = true;
+    }
+    cv.notify_one();
+    if(t.joinable()) t.join();
+}
+
+/* 
+void Preview_renderer::draw_frames()
+Description:
+Drawing thread, waits for snapshots and writes each one over "<name>.ppm" until stopped.
+
+Parameters: 
+
+Output: -
+ */
+void Preview_renderer::draw_frames()
+{
+    Snapshot s{};
+    std::string file = name + ".ppm";
+    for(;;){
+        {
+            std::unique_lock<std::mutex> l{m};
+            cv.wait(l, [this]{return fresh || stop;});
+            if(!fresh) return;
+            std::swap(s, pending);
+            fresh = false;
+        }
+        
+        TRACE_SCOPE("preview_frame");
+        if(!canvas.open_ppm_file(file)) continue;
+        size_t sc = ids.size();
+        for(size_t k = 0; k < sc; ++k){
+            Color<float> d = ids[k] < 0 ? Color<float>{} : s.b[ids[k]];
+            canvas.write_color(k, Quad::to_color(d));
+        }
+        canvas.close_ppm_file();
+        ++frames;
+        std::cout << "Preview sweep " << s.sweep << ": residual r " << s.residual[0] 
+            << " g " << s.residual[1] << " b " << s.residual[2] << std::endl;
+    }
+}
@@ -0,0 +1,59 @@
+/* date = October 20th 2026 10:30 am */
+
+/* 
+class Preview_renderer
+referenced by: main.cpp
+Inherits From: class Solver_observer
+Low resolution preview of a solve in progress, written to "<name>.ppm" while the solver is still running.
+
+Elements are flat shaded with their current B, so the element seen by every sample is all a frame needs: 
+on_begin ray casts the camera once into an element index buffer, and every frame after that is a lookup. 
+on_progress only copies B into a pending snapshot and wakes the drawing thread, the solver never waits 
+on a frame being written. Snapshots arriving while a frame is drawn replace each other, only the latest is drawn.
+The drawing thread lives from on_begin to on_end, which draws the last snapshot before joining.
+ */
+
+#ifndef PREVIEW_RENDERER_H
+#define PREVIEW_RENDERER_H
+
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include "solver_observer.h"
+#include "camera.h"
+#include "canvas.h"
+#include "element.h"
+
+class Preview_renderer : public Solver_observer{
+    public:
+    Preview_renderer(const Camera& c_, int th, int tw, std::string name_, size_t cadence_ = 1);
+    ~Preview_renderer();
+    // NOTE(Alex): Solver_observer override
+    void on_begin(const Quad_manager& qm) override;
+    void on_progress(size_t sweep, const Stimuli& r, const Stimuli& g, const Stimuli& b) override;
+    void on_end() override;
+    size_t get_frame_count()const{return frames;}
+    private:
+    struct Snapshot{
+        size_t sweep;
+        float residual[3];
+        std::vector<Color<float>> b;
+    };
+    void draw_frames();
+    Camera c;
+    Canvas canvas;
+    std::string name;
+    std::vector<ElemIndex> ids;
+    Snapshot pending;
+    bool fresh;
+    bool stop;
+    std::atomic<size_t> frames;
+    std::mutex m;
+    std::condition_variable cv;
+    std::thread t;
+};
+
+#endif //PREVIEW_RENDERER_H
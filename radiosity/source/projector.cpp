@@ -1 +1,350 @@
 #include "projector.h"
+#include <cfloat>
+#include <algorithm>
+#include <cmath>
+#include <atomic>
+#include <memory>
+#include "utility.h"
+#include "instrumentation.h"
+#include "trace.h"
+#include "mem_accounting.h"
+
+/* 
+Tile side in pixels.
+ */
+static const size_t tile_size = 32;
+
+/* 
+static size_t get_tile_count(const Canvas& canvas)
+Description:
+Jobs a canvas is split into: tile_size x tile_size tiles plus one job for the samples outside the tile grid.
+ */
+static size_t get_tile_count(const Canvas& canvas)
+{
+    size_t tcx = (size_t(canvas.get_width()) + tile_size - 1) / tile_size;
+    size_t tcy = (size_t(canvas.get_height()) + tile_size - 1) / tile_size;
+    return tcx * tcy + 1;
+}
+
+/* 
+static void render_tile(const Canvas& canvas, size_t t, const std::function<void(size_t)>& sample)
+Description:
+Calls sample with the write-order index of every sample of the t-th job of a canvas.
+
+Parameters: 
+const Canvas& canvas: Canvas.
+size_t t: Job index in [0,get_tile_count(canvas)).
+const std::function<void(size_t)>& sample: Renders the k-th sample.
+
+Output: -
+ */
+static void render_tile(const Canvas& canvas, size_t t, const std::function<void(size_t)>& sample)
+{
+    size_t sc = canvas.get_sample_count();
+    size_t tw = canvas.get_width();
+    size_t th = canvas.get_height();
+    size_t tcx = (tw + tile_size - 1) / tile_size;
+    size_t tc = get_tile_count(canvas) - 1;
+    if(t == tc)
+    {
+        // NOTE(Alex): First and last samples sit outside the tile grid
+        sample(0);
+        sample(sc - 1);
+        return;
+    }
+    size_t r0 = (t / tcx) * tile_size;
+    size_t c0 = (t % tcx) * tile_size;
+    size_t r1 = std::min(r0 + tile_size, th);
+    size_t c1 = std::min(c0 + tile_size, tw);
+    for(size_t r = r0; r < r1; ++r){
+        for(size_t c = c0; c < c1; ++c){
+            sample(1 + r*tw + c);
+        }
+    }
+}
+
+/* 
+void Projector::for_each_tile(const Canvas& canvas, const std::function<void(size_t)>& sample)
+Description:
+Splits a canvas into tiles run on the work-stealing pool and calls sample 
+with the write-order index of every sample, each exactly once.
+
+Parameters: 
+const Canvas& canvas: Canvas to split.
+const std::function<void(size_t)>& sample: Renders the k-th sample.
+
+Output: -
+ */
+void Projector::for_each_tile(const Canvas& canvas, const std::function<void(size_t)>& sample)
+{
+    pool.parallel_for(get_tile_count(canvas), [&](size_t t){render_tile(canvas, t, sample);});
+}
+
+/* 
+bool Projector::begin_canvas(Canvas& canvas, const std::string& name)
+Description:
+Prepares a canvas for shading: opens "<name>.ppm" without exposures, allocates radiance with them.
+
+Parameters: 
+Canvas& canvas: Canvas, not opened yet.
+const std::string& name: Output file name without extension.
+
+Output:
+bool: Whether the canvas can be shaded.
+ */
+bool Projector::begin_canvas(Canvas& canvas, const std::string& name)
+{
+    if(exposures.empty()) return canvas.open_ppm_file(name + ".ppm");
+    canvas.allocate_radiance();
+    return true;
+}
+
+/* 
+bool Projector::end_canvas(Canvas& canvas, const std::string& name)
+Description:
+Finishes a shaded canvas: closes the PPM file without exposures, with them writes "<name>.pfm" and 
+tone maps one PPM per exposure.
+
+Parameters: 
+Canvas& canvas: Shaded canvas.
+const std::string& name: Output file name without extension.
+
+Output:
+bool: Whether every file was written.
+ */
+bool Projector::end_canvas(Canvas& canvas, const std::string& name)
+{
+    if(exposures.empty())
+    {
+        canvas.close_ppm_file();
+        return true;
+    }
+    bool ok = canvas.write_pfm(name + ".pfm");
+    for(size_t i = 0; i < exposures.size(); ++i){
+        ok = canvas.write_tone_mapped(i == 0 ? name + ".ppm" : name + "_" + std::to_string(i) + ".ppm", exposures[i]) && ok;
+    }
+    return ok;
+}
+
+/* 
+void Projector::render_canvas(Canvas& canvas, const std::string& name, const std::function<Color<int>(size_t)>& color, const std::function<Color<float>(size_t)>& radiance)
+Description:
+Shades every sample of a canvas in parallel tiles and writes the output files. 
+Without exposures color is written straight into "<name>.ppm", with exposures radiance is written into "<name>.pfm" 
+and tone mapped into one PPM per exposure. 
+Each tile writes its samples at their write-order index, so files are byte-identical to walking the canvas on one thread.
+
+Parameters: 
+Canvas& canvas: Canvas, not opened yet.
+const std::string& name: Output file name without extension.
+const std::function<Color<int>(size_t)>& color: LDR color of the k-th sample.
+const std::function<Color<float>(size_t)>& radiance: HDR radiance of the k-th sample.
+
+Output: -
+ */
+void Projector::render_canvas(Canvas& canvas, const std::string& name, const std::function<Color<int>(size_t)>& color, const std::function<Color<float>(size_t)>& radiance)
+{
+    if(!begin_canvas(canvas, name)) return;
+    if(exposures.empty()) for_each_tile(canvas, [&](size_t k){canvas.write_color(k, color(k));});
+    else for_each_tile(canvas, [&](size_t k){canvas.write_radiance(k, radiance(k));});
+    end_canvas(canvas, name);
+}
+
+/* 
+static float contrast(const Color<float>& a, const Color<float>& b)
+Description:
+Largest channel difference after compressing radiance into [0,1) with x/(1+x), so the emitter 
+does not flag every pixel next to it at any exposure.
+ */
+static float contrast(const Color<float>& a, const Color<float>& b)
+{
+    auto f = [](float x){return x / (1.0f + x);};
+    return std::max({std::fabs(f(a.r) - f(b.r)), std::fabs(f(a.g) - f(b.g)), std::fabs(f(a.b) - f(b.b))});
+}
+
+/* 
+Color<float> Projector::trace(Displayable& d, const Ray& r, ElemIndex& i)const
+Description:
+Radiance seen along a ray, final gathered when gather is set.
+
+Parameters: 
+Displayable& d: Displayable to request radiance from.
+const Ray& r: Ray.
+ElemIndex& i: Element index of the hit quad, -1 on a miss.
+
+Output:
+Color<float>: Radiance.
+ */
+Color<float> Projector::trace(Displayable& d, const Ray& r, ElemIndex& i)const
+{
+    if(gather) return d.request_gathered_radiance(r, 0.001f, FLT_MAX, i);
+    return d.request_radiance(r, 0.001f, FLT_MAX, i);
+}
+
+/* 
+Color<float> Projector::resolve_sample(Displayable& d, const Camera& c, const Canvas& canvas, const std::vector<Color<float>>& rc, const std::vector<ElemIndex>& ri, size_t k)const
+Description:
+Final radiance of the k-th sample for adaptive antialiasing. Keeps the first pass sample unless a 4-neighbour 
+hits another Face or exceeds the contrast threshold, then averages aa_n x aa_n stratified subsamples 
+over the pixel footprint. Jitter is seeded by the sample index so renders are repeatable.
+
+Parameters: 
+Displayable& d: Displayable to request radiance from.
+const Camera& c: Camera of the canvas.
+const Canvas& canvas: Canvas.
+const std::vector<Color<float>>& rc: First pass radiance, per sample.
+const std::vector<ElemIndex>& ri: First pass hit Face, per sample.
+size_t k: Sample index in write order.
+
+Output:
+Color<float>: Radiance.
+ */
+Color<float> Projector::resolve_sample(Displayable& d, const Camera& c, const Canvas& canvas, 
+                                       const std::vector<Color<float>>& rc, const std::vector<ElemIndex>& ri, size_t k)const
+{
+    size_t sc = canvas.get_sample_count();
+    // NOTE(Alex): First and last samples are off the image grid, they have no neighbours
+    if(k == 0 || k == sc - 1) return rc[k];
+    
+    auto t = canvas.get_sample_pos(k);
+    const int nb[4][2] = {{1,0},{-1,0},{0,1},{0,-1}};
+    bool edge = false;
+    for(auto& a:nb){
+        size_t n = canvas.get_sample_index(std::get<0>(t) + a[0], std::get<1>(t) + a[1]);
+        if(n == sc) continue;
+        if(ri[n] != ri[k] || contrast(rc[n], rc[k]) > aa_contrast)
+        {
+            edge = true;
+            break;
+        }
+    }
+    if(!edge) return rc[k];
+    
+    uint64_t s = Fnv1a(&k, sizeof(k));
+    float in = 1.0f / static_cast<float>(aa_n);
+    Color<float> acc{0,0,0};
+    for(int b = 0; b < aa_n; ++b){
+        for(int a = 0; a < aa_n; ++a){
+            float du = (static_cast<float>(a) + Xorshift_float(s)) * in - 0.5f;
+            float dv = (static_cast<float>(b) + Xorshift_float(s)) * in - 0.5f;
+            ElemIndex i;
+            acc += trace(d, c.get_ray(canvas.get_p_sample(k, du, dv)), i);
+        }
+    }
+    return acc * (in * in);
+}
+
+/* 
+bool Projector::render_cameras(Displayable& d, const std::vector<Camera>& cams, int th, int tw, std::vector<bool>* written)
+Description:
+Ray casts several views against the same displayable at once. The tiles of every view go into a single 
+parallel_for, so workers move on to the next view without waiting for the slowest tile of the current one, 
+and the job finishing the last tile of a view writes that view's files while other views are still rendering. 
+Output is the same as rendering the views one by one, "<camera name>.ppm" (and .pfm with exposures). 
+Every canvas is open for the whole batch, with exposures each one holds its float buffer until it is written. 
+With antialiasing a first batch takes one sample per pixel for every view, the second one resolves and writes them.
+
+Parameters: 
+Displayable& d: Displayable to request color data from.
+const std::vector<Camera>& cams: Cameras, names MUST be unique.
+ int th: Image Height.
+ int tw: Image Width.
+ std::vector<bool>* written: Per camera, whether its canvas opened, every tile was shaded and its files were written. May be null.
+
+Output:
+bool: Whether every view was fully rendered, false when cancelled.
+ */
+bool Projector::render_cameras(Displayable& d, const std::vector<Camera>& cams, int th, int tw, std::vector<bool>* written)
+{
+    INSTRUMENT_SCOPE("render");
+    std::vector<std::unique_ptr<Canvas>> canvases;
+    std::vector<size_t> first{0};
+    std::vector<std::atomic<size_t>> left(cams.size());
+    std::vector<std::atomic<bool>> skipped(cams.size());
+    // NOTE(Alex): char, not bool, the jobs closing different views write it concurrently
+    std::vector<char> ok(cams.size(), 0);
+    canvases.reserve(cams.size());
+    for(size_t v = 0; v < cams.size(); ++v){
+        const Camera& c = cams[v];
+        canvases.push_back(std::make_unique<Canvas>(c.X, c.Y, c.O, c.fw, c.fh, th, tw, c.cg));
+        size_t tc = begin_canvas(*canvases[v], c.name) ? get_tile_count(*canvases[v]) : 0;
+        left[v].store(tc);
+        skipped[v].store(false);
+        first.push_back(first.back() + tc);
+    }
+    // NOTE(Alex): Views that failed to open own no jobs, their first index repeats
+    auto view = [&](size_t j){return size_t(std::upper_bound(first.begin(), first.end(), j) - first.begin()) - 1;};
+    
+    bool aa = aa_n > 1;
+    std::vector<std::vector<Color<float>>> rc(aa ? cams.size() : 0);
+    std::vector<std::vector<ElemIndex>> ri(aa ? cams.size() : 0);
+    Mem_account aa_acc{mem_category::framebuffer};
+    if(aa)
+    {
+        size_t bytes = 0;
+        for(size_t v = 0; v < cams.size(); ++v){
+            rc[v].resize(canvases[v]->get_sample_count());
+            ri[v].resize(canvases[v]->get_sample_count());
+            bytes += rc[v].size()*(sizeof(Color<float>) + sizeof(ElemIndex));
+        }
+        aa_acc.set(bytes);
+        // NOTE(Alex): Elements of a Face share vertex colors, only a change of Face is a geometric edge
+        std::vector<Face_grid> grids = d.request_face_grids();
+        auto face = [&](ElemIndex i){
+            for(size_t f = 0; f < grids.size(); ++f){
+                if(i >= grids[f].si && size_t(i - grids[f].si) < grids[f].rc*grids[f].cc) return static_cast<ElemIndex>(f);
+            }
+            return ElemIndex(-1);
+        };
+        pool.parallel_for(first.back(), [&](size_t j){
+            if(is_cancelled()) return;
+            size_t v = view(j);
+            const Camera& c = cams[v];
+            Canvas& canvas = *canvases[v];
+            TRACE_SCOPE("tile_samples");
+            render_tile(canvas, j - first[v], [&](size_t k){
+                ElemIndex i;
+                rc[v][k] = trace(d, c.get_ray(canvas.get_p_sample(k)), i);
+                ri[v][k] = face(i);
+            });
+        });
+    }
+    
+    pool.parallel_for(first.back(), [&](size_t j){
+        size_t v = view(j);
+        const Camera& c = cams[v];
+        Canvas& canvas = *canvases[v];
+        // NOTE(Alex): Cancelled tiles still count down so every canvas gets closed
+        if(!is_cancelled())
+        {
+            TRACE_SCOPE("tile");
+            if(aa)
+            {
+                render_tile(canvas, j - first[v], [&](size_t k){
+                    Color<float> x = resolve_sample(d, c, canvas, rc[v], ri[v], k);
+                    if(exposures.empty()) canvas.write_color(k, Quad::to_color(x));
+                    else canvas.write_radiance(k, x);
+                });
+            }
+            else if(exposures.empty() && !gather)
+            {
+                render_tile(canvas, j - first[v], [&](size_t k){
+                    canvas.write_color(k, d.request_color(c.get_ray(canvas.get_p_sample(k)), 0.001f, FLT_MAX));
+                });
+            }
+            else
+            {
+                render_tile(canvas, j - first[v], [&](size_t k){
+                    ElemIndex i;
+                    Color<float> x = trace(d, c.get_ray(canvas.get_p_sample(k)), i);
+                    if(exposures.empty()) canvas.write_color(k, Quad::to_color(x));
+                    else canvas.write_radiance(k, x);
+                });
+            }
+        }
+        else skipped[v] = true;
+        if(left[v].fetch_sub(1) == 1) ok[v] = end_canvas(canvas, c.name) && !skipped[v];
+    });
+    if(written) written->assign(ok.begin(), ok.end());
+    return !is_cancelled();
+}
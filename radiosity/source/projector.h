@@ -1,11 +1,65 @@
 /* date = March 16th 2021 2:34 pm */
 
+/* 
+class Projector
+Derived Classes: class OrthoProjector, class PerspectiveProjector, class RasterProjector
+Base class of rendering systems, holds the tiled renderer shared by all of them. 
+render_cameras ray casts any list of cameras concurrently, e.g. a camera path for a turntable.
+
+Antialiasing (set_antialiasing) is adaptive: every pixel gets one sample first, then only pixels whose 
+4-neighbours hit a different surface or differ by more than contrast (per channel, after x/(1+x) compression) 
+are resampled with n x n stratified jittered subsamples. Elements of one Face are Gouraud 
+continuous, so the hit test compares Faces rather than elements. Without it output matches the single sample renderer.
+
+set_final_gather shades ray cast samples with the displayable's final gather pass (see final_gather.h) 
+instead of the interpolated vertex colors, the displayable has to enable it first.
+
+Without exposures a canvas is rendered straight into "<name>.ppm". With exposures set it is 
+rendered once as HDR radiance into "<name>.pfm", then tone mapped into "<name>.ppm" for the 
+first exposure and "<name>_<i>.ppm" for the i-th one.
+
+Tiles run on tc pool threads, every hardware thread by default.
+set_cancel points render_cameras at a flag checked before every tile, once set the remaining tiles are skipped.
+ */
+
 #ifndef PROJECTOR_H
 #define PROJECTOR_H
 
+#include <functional>
+#include <string>
+#include <vector>
+#include <atomic>
+#include "vec3.h"
+#include "ray.h"
+#include "canvas.h"
+#include "camera.h"
+#include "displayable.h"
+#include "thread_pool.h"
+
 class Projector{
     public:
-    Projector()=default;
+    Projector(size_t tc = 0):pool{tc},exposures{},aa_n{1},aa_contrast{0.02f},gather{false},cancel{nullptr}{}
+    void set_exposures(const std::vector<float>& e){exposures = e;}
+    void set_antialiasing(int n, float contrast){aa_n = n; aa_contrast = contrast;}
+    void set_final_gather(bool g){gather = g;}
+    void set_cancel(const std::atomic<bool>* c){cancel = c;}
+    bool render_cameras(Displayable& d, const std::vector<Camera>& cams, int th, int tw, std::vector<bool>* written = nullptr);
+    size_t get_thread_count()const{return pool.get_thread_count();}
+    protected:
+    void render_canvas(Canvas& canvas, const std::string& name, const std::function<Color<int>(size_t)>& color, const std::function<Color<float>(size_t)>& radiance);
+    void for_each_tile(const Canvas& canvas, const std::function<void(size_t)>& sample);
+    bool begin_canvas(Canvas& canvas, const std::string& name);
+    bool end_canvas(Canvas& canvas, const std::string& name);
+    bool is_cancelled()const{return cancel && *cancel;}
+    Color<float> trace(Displayable& d, const Ray& r, ElemIndex& i)const;
+    Color<float> resolve_sample(Displayable& d, const Camera& c, const Canvas& canvas, 
+                                const std::vector<Color<float>>& rc, const std::vector<ElemIndex>& ri, size_t k)const;
+    Thread_pool pool;
+    std::vector<float> exposures;
+    int aa_n;
+    float aa_contrast;
+    bool gather;
+    const std::atomic<bool>* cancel;
 };
 
 #endif //PROJECTOR_H
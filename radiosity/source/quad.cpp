@@ -1,10 +1,46 @@
 #include "quad.h"
 
+/* 
+Color<int> Quad::get_color(float u, float v)
+Description:
+Low dynamic range color, radiance converted to Range [0-255] without clamping.
+
+Parameters: 
+float u: Hit U coordinate.
+float v: Hit V coordinate.
+
+Output:
+Color<int>: Integer color.
+ */
+Color<int> Quad::get_color(float u, float v)
+{
+    return to_color(get_radiance(u, v));
+}
+
+/* 
+Color<int> Quad::to_color(const Color<float>& d)
+Description:
+Radiance converted to Range [0-255] without clamping, the conversion used by get_color.
+
+Parameters: 
+const Color<float>& d: Radiance.
+
+Output:
+Color<int>: Integer color.
+ */
+Color<int> Quad::to_color(const Color<float>& d)
+{
+    int ir = int(255.99 * d.r);
+    int ig = int(255.99 * d.g);
+    int ib = int(255.99 * d.b);
+    return Color<int>{ir,ig,ib};
+}
+
 /* 
 Correct!!! - C
  */
 // NOTE(Alex): XY (0,0) (5,5) Z = 0
-Color<int> Quad_XY_Z0::get_color(float u, float v)
+Color<float> Quad_XY_Z0::get_radiance(float u, float v)
 {
     float tx = u;
     float ty = v;
@@ -18,18 +54,14 @@ Color<int> Quad_XY_Z0::get_color(float u, float v)
     Vec3<float> b = Lerp(c2,c3, tx);
     Vec3<float> d = Lerp(a,b,ty);
     
-    int ir = int(255.99 * d.r);
-    int ig = int(255.99 * d.g);
-    int ib = int(255.99 * d.b);
-    
-    return Color<int>{ir,ig,ib};
+    return d;
 }
 
 /* 
 Correct!!! - C
  */
 // NOTE(Alex): YZ (0,0) (5,5) X = 0
-Color<int> Quad_YZ_X0::get_color(float u, float v)
+Color<float> Quad_YZ_X0::get_radiance(float u, float v)
 {
     float tx = 1.0f - u;
     float ty = v;
@@ -43,10 +75,7 @@ Color<int> Quad_YZ_X0::get_color(float u, float v)
     Vec3<float> b = Lerp(c2,c3, tx);
     Vec3<float> d = Lerp(a,b,ty);
     
-    int ir = int(255.99 * d.r);
-    int ig = int(255.99 * d.g);
-    int ib = int(255.99 * d.b);
-    return Color<int>{ir,ig,ib};
+    return d;
 }
 
 /* 
@@ -54,7 +83,7 @@ Correct!!! - C
  */
 
 // NOTE(Alex): XZ (0,0) (5,5) Y = 0
-Color<int> Quad_XZ_Y0::get_color(float u, float v)
+Color<float> Quad_XZ_Y0::get_radiance(float u, float v)
 {
     float tx = 1.0f - u;
     float ty = 1.0f - v;
@@ -68,10 +97,7 @@ Color<int> Quad_XZ_Y0::get_color(float u, float v)
     Vec3<float> b = Lerp(c2,c3, tx);
     Vec3<float> d = Lerp(a,b,ty);
     
-    int ir = int(255.99 * d.r);
-    int ig = int(255.99 * d.g);
-    int ib = int(255.99 * d.b);
-    return Color<int>{ir,ig,ib};
+    return d;
 }
 
 /* 
@@ -79,7 +105,7 @@ Correct!!! - C
  */
 
 // NOTE(Alex): YZ (0,0) (5,5) X = 5.0f
-Color<int> Quad_YZ_X5::get_color(float u, float v)
+Color<float> Quad_YZ_X5::get_radiance(float u, float v)
 {
     float tx = u;
     float ty = v;
@@ -93,17 +119,14 @@ Color<int> Quad_YZ_X5::get_color(float u, float v)
     Vec3<float> b = Lerp(c2,c3, tx);
     Vec3<float> d = Lerp(a,b,ty);
     
-    int ir = int(255.99 * d.r);
-    int ig = int(255.99 * d.g);
-    int ib = int(255.99 * d.b);
-    return Color<int>{ir,ig,ib};
+    return d;
 }
 
 /* 
 Correct!!! - C
  */
 // NOTE(Alex): XZ (0,0) (5,5) Y = 5.0f
-Color<int> Quad_XZ_Y5::get_color(float u, float v)
+Color<float> Quad_XZ_Y5::get_radiance(float u, float v)
 {
     float tx = u;
     float ty = v;
@@ -117,10 +140,7 @@ Color<int> Quad_XZ_Y5::get_color(float u, float v)
     Vec3<float> b = Lerp(c2,c3, tx);
     Vec3<float> d = Lerp(a,b,ty);
     
-    int ir = int(255.99 * d.r);
-    int ig = int(255.99 * d.g);
-    int ib = int(255.99 * d.b);
-    return Color<int>{ir,ig,ib};
+    return d;
 }
 
 bool Quad_XY_Z0::hit(Ray & r, float tMin, float tMax, HitRec & HitRecord){
@@ -209,3 +229,74 @@ bool Quad_XZ_Y5::hit(Ray & r, float tMin, float tMax, HitRec & HitRecord){
 }
 
 
+
+
+/* 
+static bool corners_in_hemisphere(const Vec3<float> (&q)[4], const Vec3<float>& p, const Vec3<float>& n)
+Description:
+Plane test used by every in_hemisphere override, a Quad lies at least partly inside the hemisphere 
+of an element when any of its corners is strictly in front of the element's tangent plane.
+
+Parameters: 
+const Vec3<float> (&q)[4]: Quad corners in World-Space.
+const Vec3<float>& p: Element's position in World-Space.
+const Vec3<float>& n: Element's normal.
+
+Output:
+bool: Whether any corner lies in front of the tangent plane.
+ */
+static bool corners_in_hemisphere(const Vec3<float> (&q)[4], const Vec3<float>& p, const Vec3<float>& n){
+    for(auto& a:q){
+        if(dot(a - p, n) > 0.0001f) return true;
+    }
+    return false;
+}
+
+bool Quad_XY_Z0::in_hemisphere(const Vec3<float>& p, const Vec3<float>& n){
+    Vec3<float> q[4]{{x0,y0,k},{x1,y0,k},{x0,y1,k},{x1,y1,k}};
+    return corners_in_hemisphere(q, p, n);
+}
+
+bool Quad_YZ_X0::in_hemisphere(const Vec3<float>& p, const Vec3<float>& n){
+    Vec3<float> q[4]{{k,y0,z0},{k,y1,z0},{k,y0,z1},{k,y1,z1}};
+    return corners_in_hemisphere(q, p, n);
+}
+
+bool Quad_XZ_Y0::in_hemisphere(const Vec3<float>& p, const Vec3<float>& n){
+    Vec3<float> q[4]{{x0,k,z0},{x1,k,z0},{x0,k,z1},{x1,k,z1}};
+    return corners_in_hemisphere(q, p, n);
+}
+
+bool Quad_YZ_X5::in_hemisphere(const Vec3<float>& p, const Vec3<float>& n){
+    Vec3<float> q[4]{{k,y0,z0},{k,y1,z0},{k,y0,z1},{k,y1,z1}};
+    return corners_in_hemisphere(q, p, n);
+}
+
+bool Quad_XZ_Y5::in_hemisphere(const Vec3<float>& p, const Vec3<float>& n){
+    Vec3<float> q[4]{{x0,k,z0},{x1,k,z0},{x0,k,z1},{x1,k,z1}};
+    return corners_in_hemisphere(q, p, n);
+}
+
+/* 
+get_point overrides
+Inverse of hit, World-Space point at hit coordinates (u,v).
+ */
+Vec3<float> Quad_XY_Z0::get_point(float u, float v)const{
+    return {x0 + u*(x1 - x0), y0 + v*(y1 - y0), k};
+}
+
+Vec3<float> Quad_YZ_X0::get_point(float u, float v)const{
+    return {k, y0 + v*(y1 - y0), z0 + u*(z1 - z0)};
+}
+
+Vec3<float> Quad_XZ_Y0::get_point(float u, float v)const{
+    return {x0 + v*(x1 - x0), k, z0 + u*(z1 - z0)};
+}
+
+Vec3<float> Quad_YZ_X5::get_point(float u, float v)const{
+    return {k, y0 + v*(y1 - y0), z0 + u*(z1 - z0)};
+}
+
+Vec3<float> Quad_XZ_Y5::get_point(float u, float v)const{
+    return {x0 + v*(x1 - x0), k, z0 + u*(z1 - z0)};
+}
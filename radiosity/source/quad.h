@@ -52,7 +52,11 @@ class Quad : public hitable, public Element
     c{{c0},{c1},{c2},{c3}}
     {}
     virtual bool hit(Ray & r, float tMin, float tMax, HitRec & HitRecord) = 0;
-    virtual Color<int> get_color(float u, float v) = 0;
+    virtual Color<float> get_radiance(float u, float v) = 0;
+    virtual Vec3<float> get_point(float u, float v)const = 0;
+    Color<int> get_color(float u, float v);
+    static Color<int> to_color(const Color<float>& d);
+    virtual bool in_hemisphere(const Vec3<float>& p, const Vec3<float>& n) = 0;
     Color<float> c[4];
 };
 
@@ -68,7 +72,9 @@ class Quad_XY_Z0 : public Quad
     // NOTE(Alex): hitable override
     bool hit(Ray & r, float tMin, float tMax, HitRec & HitRecord) override;
     // NOTE(Alex): Quad override
-    Color<int> get_color(float u, float v) override;
+    Color<float> get_radiance(float u, float v) override;
+    Vec3<float> get_point(float u, float v)const override;
+    bool in_hemisphere(const Vec3<float>& p, const Vec3<float>& n) override;
     
     private:
     float x0,x1,y0,y1,k;
@@ -86,7 +92,9 @@ class Quad_YZ_X0 : public Quad
     // NOTE(Alex): hitable override
     bool hit(Ray & r, float tMin, float tMax, HitRec & HitRecord) override;
     // NOTE(Alex): Quad override
-    Color<int> get_color(float u, float v) override;
+    Color<float> get_radiance(float u, float v) override;
+    Vec3<float> get_point(float u, float v)const override;
+    bool in_hemisphere(const Vec3<float>& p, const Vec3<float>& n) override;
     private:
     float y0,y1,z0,z1,k;
 };
@@ -103,7 +111,9 @@ class Quad_XZ_Y0 : public Quad
     // NOTE(Alex): hitable override
     bool hit(Ray & r, float tMin, float tMax, HitRec & HitRecord) override;
     // NOTE(Alex): Quad override
-    Color<int> get_color(float u, float v) override;
+    Color<float> get_radiance(float u, float v) override;
+    Vec3<float> get_point(float u, float v)const override;
+    bool in_hemisphere(const Vec3<float>& p, const Vec3<float>& n) override;
     private:
     float x0,x1,z0,z1,k;
 };
@@ -120,7 +130,9 @@ class Quad_YZ_X5 : public Quad
     // NOTE(Alex): hitable override
     bool hit(Ray & r, float tMin, float tMax, HitRec & HitRecord) override;
     // NOTE(Alex): Quad override
-    Color<int> get_color(float u, float v) override;
+    Color<float> get_radiance(float u, float v) override;
+    Vec3<float> get_point(float u, float v)const override;
+    bool in_hemisphere(const Vec3<float>& p, const Vec3<float>& n) override;
     private:
     float y0,y1,z0,z1,k;
 };
@@ -137,7 +149,9 @@ class Quad_XZ_Y5 : public Quad
     // NOTE(Alex): hitable override
     bool hit(Ray & r, float tMin, float tMax, HitRec & HitRecord) override;
     // NOTE(Alex): Quad override
-    Color<int> get_color(float u, float v) override;
+    Color<float> get_radiance(float u, float v) override;
+    Vec3<float> get_point(float u, float v)const override;
+    bool in_hemisphere(const Vec3<float>& p, const Vec3<float>& n) override;
     private:
     float x0,x1,z0,z1,k;
 };
@@ -1,8 +1,14 @@
 #include "quad_manager.h"
+#include "instrumentation.h"
+#include "trace.h"
+#include "thread_pool.h"
+#include <algorithm>
 
 Quad_manager::Quad_manager(float fw_, int hps_):
 fw{fw_},
 hps{hps_},
+hm_x{hm_xc},
+hm_y{hm_yc},
 ei{0},
 quads{},
 f_xy_z0{fw,hps,ei,quads},
@@ -10,55 +16,334 @@ f_yz_x0{fw,hps,ei,quads},
 f_xz_y0{fw,hps,ei,quads},
 f_yz_x5{fw,hps,ei,quads},
 f_xz_y5{fw,hps,ei,quads},
-e{fw,hps,ei,quads}
+e{fw,hps,ei,quads},
+cl{},
+cl_i{},
+acc{mem_category::elements}
 {
+    build_candidate_lists();
+    
+    // NOTE(Alex): Every Quad type has the same layout, its shared_ptr control block is counted as one more pointer pair
+    size_t bytes = quads.size()*(sizeof(Quad_XY_Z0) + 2*sizeof(std::shared_ptr<Quad>)) + cl_i.size()*sizeof(size_t);
+    for(auto& c:cl) bytes += c.capacity()*sizeof(Quad*);
+    acc.set(bytes);
+}
+
+/* 
+void Quad_manager::build_candidate_lists()
+Description:
+Builds once, with plane tests, the list of Quads lying at least partly inside each element's hemisphere.
+Every Face is planar, so all elements sharing a tangent plane share the same candidate list, 
+cl_i maps each element index onto its list in cl.
+
+Parameters: 
+
+Output: -
+ */
+void Quad_manager::build_candidate_lists(){
+    std::vector<std::pair<Vec3<float>,float>> planes;
+    cl_i.resize(quads.size());
+    for(auto& a:quads){
+        Vec3<float> n = a->get_n();
+        float d = dot(n, a->get_p());
+        size_t pi = 0;
+        for(;pi<planes.size();++pi){
+            auto& pl = planes[pi];
+            if((pl.first - n).squared_norm() < 0.0001f && std::fabs(pl.second - d) < 0.0001f) break;
+        }
+        if(pi == planes.size())
+        {
+            planes.push_back({n,d});
+            std::vector<Quad*> c{};
+            for(auto& b:quads){
+                if(b.get() != a.get() && b->in_hemisphere(a->get_p(), n)) c.push_back(b.get());
+            }
+            c.shrink_to_fit();
+            cl.push_back(std::move(c));
+        }
+        cl_i[a->get_i()] = pi;
+    }
 }
 
 Color<int> Quad_manager::get_color(Ray r, float tMin, float tMax){
     HitRec rec{};
-    std::shared_ptr<Quad> a_ref{};
-    for(auto a:quads)
+    Quad* a_ref = closest_hit(r, tMin, tMax, rec);
+    if(a_ref) return a_ref->get_color(rec.u,rec.v);
+    else return {0,0,0};
+}
+
+Color<float> Quad_manager::get_radiance(Ray r, float tMin, float tMax){
+    ElemIndex i;
+    return get_radiance(r, tMin, tMax, i);
+}
+
+/* 
+Color<float> Quad_manager::get_radiance(Ray r, float tMin, float tMax, ElemIndex& i)
+Description:
+Radiance of the closest quad hit by a ray.
+
+Parameters: 
+Ray r: Ray.
+float tMin: Ray minimum collision testing boundary. 
+float tMax: Ray maximum collision testing boundary. 
+ElemIndex& i: Element index of the hit quad, -1 on a miss.
+
+Output:
+Color<float>: Radiance, black on a miss.
+ */
+Color<float> Quad_manager::get_radiance(Ray r, float tMin, float tMax, ElemIndex& i){
+    HitRec rec{};
+    Quad* a_ref = closest_hit(r, tMin, tMax, rec);
+    i = a_ref ? a_ref->get_i() : -1;
+    if(a_ref) return a_ref->get_radiance(rec.u,rec.v);
+    else return {0,0,0};
+}
+
+/* 
+Quad* Quad_manager::closest_hit(Ray r, float tMin, float tMax, HitRec& rec)const
+Description:
+Closest quad hit by a ray, ties go to the later quad.
+
+Parameters: 
+Ray r: Ray.
+float tMin: Ray minimum collision testing boundary. 
+float tMax: Ray maximum collision testing boundary. 
+HitRec& rec: Hit record of the closest hit.
+
+Output:
+Quad*: Hit quad, nullptr on a miss.
+ */
+Quad* Quad_manager::closest_hit(Ray r, float tMin, float tMax, HitRec& rec)const{
+    Quad* a_ref = nullptr;
+    for(auto& a:quads)
     {
         if(a->hit(r, tMin, tMax, rec))
         {
             tMax = rec.t;
-            a_ref=a;
+            a_ref = a.get();
         }
     }
-    if(a_ref.get()) return a_ref->get_color(rec.u,rec.v);
-    else return {0,0,0};
+    INSTRUMENT_RAY(a_ref, quads.size());
+    return a_ref;
 }
 
-Matrix<float,2> Quad_manager::calc_ff(){
-    
-    Matrix<float,2> ff(quads.size(),quads.size());
-    for(auto a:quads){
-        Ray r{};
-        while(a->get_ray(r))
+/* 
+bool Quad_manager::occluded(Ray r, float tMin, float tMax, const Quad* ignore)const
+Description:
+Shadow ray test, stops at the first quad hit.
+
+Parameters: 
+Ray r: Ray.
+float tMin: Ray minimum collision testing boundary. 
+float tMax: Ray maximum collision testing boundary. 
+const Quad* ignore: Quad the ray aims at, never counts as occluder.
+
+Output:
+bool: Whether any other quad is hit within [tMin,tMax].
+ */
+bool Quad_manager::occluded(Ray r, float tMin, float tMax, const Quad* ignore)const{
+    HitRec rec{};
+    for(size_t k = 0; k < quads.size(); ++k)
+    {
+        Quad* a = quads[k].get();
+        if(a != ignore && a->hit(r, tMin, tMax, rec))
         {
-            Element_ref j{};
-            if(request_element(r, 0.001f, FLT_MAX, j))
-                a->calc_ff(r, j, ff);
+            INSTRUMENT_RAY(true, k + 1);
+            return true;
         }
     }
-    return ff;
+    INSTRUMENT_RAY(false, quads.size());
+    return false;
 }
 
-bool Quad_manager::request_element(Ray r, float tMin, float tMax, Element_ref& element){
+/* 
+bool Quad_manager::calc_ff(Matrix<float,2>& ff, const std::atomic<bool>* cancel, Thread_pool* pool)
+Description:
+Fills in the Form-Factor matrix casting every element's hemicube rays, at hm_x x hm_y pixels per 
+hemicube face (hm_xc x hm_yc unless set_hemicube), every call starts each hemicube over. Rows are filled in element order, each finished block of rows is released so a 
+memory-mapped ff keeps a bounded resident footprint.
+With a pool the rows of a block are cast in parallel, one job per row. A row is only ever written by its own 
+element, in the same ray order as the serial loop, so F is bit-identical for any thread count.
+
+Parameters: 
+Matrix<float,2>& ff: Zeroed Form-Factor matrix sized element count x element count.
+const std::atomic<bool>* cancel: Checked before every element, may be null.
+Thread_pool* pool: Pool casting the rows, null casts them on the calling thread.
+
+Output:
+bool: Whether every row was filled in, false when cancelled.
+ */
+bool Quad_manager::calc_ff(Matrix<float,2>& ff, const std::atomic<bool>* cancel, Thread_pool* pool){
+    INSTRUMENT_SCOPE("calc_ff");
+    auto row = [&](size_t qi){
+        if(cancel && *cancel) return;
+        cast_row(qi, &ff(quads[qi]->get_i(), 0));
+    };
+    size_t br = ff.get_block_rows();
+    for(size_t r0 = 0; r0 < quads.size(); r0 += br){
+        size_t r1 = std::min(quads.size(), r0 + br);
+        if(pool) pool->parallel_for(r1 - r0, [&](size_t k){row(r0 + k);});
+        else for(size_t qi = r0; qi < r1; ++qi) row(qi);
+        if(cancel && *cancel)
+        {
+            ff.release_rows(0,ff.get_extent(0));
+            return false;
+        }
+        ff.release_rows(r0, r1 - r0);
+    }
+    ff.release_rows(0,ff.get_extent(0));
+    return true;
+}
+
+/* 
+bool Quad_manager::calc_ff_rows(const std::function<void(size_t, const float*)>& row_done, const std::atomic<bool>* cancel, Thread_pool* pool)
+Description:
+Casts the same Form-Factor rows as calc_ff without ever holding F: rows are cast in batches of 
+rows_per_batch into a scratch buffer, then handed to row_done one by one in element order on the calling thread, 
+so consumers like the streamed H_matrix build need no locking and see the same rows for any thread count.
+
+Parameters: 
+const std::function<void(size_t, const float*)>& row_done: Receives the element index and its row, n floats.
+const std::atomic<bool>* cancel: Checked before every element, may be null.
+Thread_pool* pool: Pool casting the rows of a batch, null casts them on the calling thread.
+
+Output:
+bool: Whether every row was handed over, false when cancelled.
+ */
+bool Quad_manager::calc_ff_rows(const std::function<void(size_t, const float*)>& row_done, const std::atomic<bool>* cancel, Thread_pool* pool){
+    INSTRUMENT_SCOPE("calc_ff");
+    const size_t rows_per_batch = 64;
+    size_t n = quads.size();
+    std::vector<float> rows(std::min(n, rows_per_batch)*n);
+    Mem_account rows_acc{mem_category::matrix, rows.size()*sizeof(float)};
+    for(size_t r0 = 0; r0 < n; r0 += rows_per_batch){
+        size_t r1 = std::min(n, r0 + rows_per_batch);
+        std::fill(rows.begin(), rows.end(), 0.0f);
+        auto row = [&](size_t k){
+            if(cancel && *cancel) return;
+            cast_row(r0 + k, rows.data() + k*n);
+        };
+        if(pool) pool->parallel_for(r1 - r0, row);
+        else for(size_t k = 0; k < r1 - r0; ++k) row(k);
+        if(cancel && *cancel) return false;
+        for(size_t k = 0; k < r1 - r0; ++k) row_done(quads[r0 + k]->get_i(), rows.data() + k*n);
+    }
+    return true;
+}
+
+/* 
+void Quad_manager::cast_row(size_t qi, float* row)
+Description:
+Casts every hemicube ray of the qi-th quad and accumulates its Form-Factors into row.
+
+Parameters: 
+size_t qi: Quad index.
+float* row: Zeroed Form-Factor row of the quad, n floats.
+
+Output: -
+ */
+void Quad_manager::cast_row(size_t qi, float* row){
+    TRACE_SCOPE("calc_ff_row");
+    auto& a = quads[qi];
+    Ray r{};
+    a->reset_hemicube(hm_x, hm_y);
+    const std::vector<Quad*>& c = cl[cl_i[a->get_i()]];
+    while(a->get_ray(r))
+    {
+        Element_ref j{};
+        if(request_element(r, 0.001f, FLT_MAX, c, j))
+            a->calc_ff(r, j, row);
+    }
+}
+
+/* 
+uint64_t Quad_manager::geometry_key()const
+Description:
+Hashes everything the Form-Factor matrix depends on: face width, hps, HemiCube resolution 
+and every element's normal and position.
+
+Parameters: 
+
+Output:
+uint64_t: FNV-1a hash of the scene geometry.
+ */
+uint64_t Quad_manager::geometry_key()const{
+    int hm_res[2]{hm_x,hm_y};
+    uint64_t h = Fnv1a(&fw, sizeof(fw));
+    h = Fnv1a(&hps, sizeof(hps), h);
+    h = Fnv1a(hm_res, sizeof(hm_res), h);
+    for(auto& a:quads){
+        Vec3<float> n = a->get_n();
+        Vec3<float> p = a->get_p();
+        h = Fnv1a(&n, sizeof(n), h);
+        h = Fnv1a(&p, sizeof(p), h);
+    }
+    return h;
+}
+
+/* 
+bool Quad_manager::request_element(Ray r, float tMin, float tMax, const std::vector<Quad*>& cl, Element_ref& element)
+Description:
+Finds the closest element hit by a hemicube ray, only Quads within the casting element's candidate list are tested.
+
+Parameters: 
+Ray r: Hemicube ray.
+float tMin: Ray minimum collision testing boundary. 
+float tMax: Ray maximum collision testing boundary. 
+const std::vector<Quad*>& cl: Candidate list of the casting element.
+Element_ref& element: Element hit.
+
+Output:
+bool: Whether an element was hit.
+ */
+bool Quad_manager::request_element(Ray r, float tMin, float tMax, const std::vector<Quad*>& cl, Element_ref& element){
     HitRec rec{};
-    std::shared_ptr<Quad> a_ref{};
-    for(auto a:quads){
+    Quad* a_ref{};
+    for(auto a:cl){
         if(a->hit(r, tMin, tMax, rec))
         {
             tMax = rec.t;
             a_ref = a;
         }
     }
+    INSTRUMENT_RAY(a_ref, cl.size());
     // NOTE(Alex): Slicing
-    if(a_ref.get()){element = *a_ref; return true;}
+    if(a_ref){element = *a_ref; return true;}
     else return false;
 }
 
+/* 
+std::vector<Face_grid> Quad_manager::get_face_grids()const
+Description:
+Element index layout of every Face, in element index order.
+
+Parameters: 
+
+Output:
+std::vector<Face_grid>: One grid per Face.
+ */
+std::vector<Face_grid> Quad_manager::get_face_grids()const{
+    return {f_xy_z0.get_grid(), f_yz_x0.get_grid(), f_xz_y0.get_grid(), 
+        f_yz_x5.get_grid(), f_xz_y5.get_grid(), e.get_grid()};
+}
+
+/* 
+std::vector<Vec3<float>> Quad_manager::get_positions()const
+Description:
+World-Space position of every element, indexed by element index.
+
+Parameters: 
+
+Output:
+std::vector<Vec3<float>>: Element positions.
+ */
+std::vector<Vec3<float>> Quad_manager::get_positions()const{
+    std::vector<Vec3<float>> p;
+    p.reserve(quads.size());
+    for(auto& a:quads) p.push_back(a->get_p());
+    return p;
+}
+
 void Quad_manager::move_radiosities(const Matrix<float,1>& r,const Matrix<float,1>& g,const Matrix<float,1>& b){
     f_xy_z0.add_radiosities(r,g,b);
     f_yz_x0.add_radiosities(r,g,b);
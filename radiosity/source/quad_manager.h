@@ -4,22 +4,43 @@
 #define QUAD_MANAGER_H
 
 #include <memory>
+#include <atomic>
+#include <functional>
 #include "vec3.h"
 #include "ray.h"
 #include "quad.h"
 #include "element.h"
 #include "face.h"
+#include "mem_accounting.h"
+
+class Thread_pool;
 
 class Quad_manager{
     public:
     Quad_manager(float fw, int hps);
     Color<int> get_color(Ray r, float tMin, float tMax);
-    Matrix<float,2> calc_ff();
+    Color<float> get_radiance(Ray r, float tMin, float tMax);
+    Color<float> get_radiance(Ray r, float tMin, float tMax, ElemIndex& i);
+    Quad* closest_hit(Ray r, float tMin, float tMax, HitRec& rec)const;
+    bool occluded(Ray r, float tMin, float tMax, const Quad* ignore)const;
+    bool calc_ff(Matrix<float,2>& ff, const std::atomic<bool>* cancel = nullptr, Thread_pool* pool = nullptr);
+    bool calc_ff_rows(const std::function<void(size_t, const float*)>& row_done, const std::atomic<bool>* cancel = nullptr, Thread_pool* pool = nullptr);
+    void set_hemicube(int xc, int yc){hm_x = xc; hm_y = yc;}
+    uint64_t geometry_key()const;
+    size_t get_count()const{return quads.size();}
+    float get_width()const{return fw;}
+    const std::vector<std::shared_ptr<Quad>>& get_quads()const{return quads;}
+    std::vector<Face_grid> get_face_grids()const;
+    std::vector<Vec3<float>> get_positions()const;
     void move_radiosities(const Matrix<float,1>& r,const Matrix<float,1>& g,const Matrix<float,1>& b);
     private:
-    bool request_element(Ray r, float tMin, float tMax, Element_ref& e);
+    void build_candidate_lists();
+    void cast_row(size_t qi, float* row);
+    bool request_element(Ray r, float tMin, float tMax, const std::vector<Quad*>& cl, Element_ref& e);
     float fw;
     int hps;
+    int hm_x;
+    int hm_y;
     ElemIndex ei;
     std::vector<std::shared_ptr<Quad>> quads;
     Face_xy_z0 f_xy_z0;
@@ -28,6 +49,12 @@ class Quad_manager{
     Face_yz_x5 f_yz_x5;
     Face_xz_y5 f_xz_y5;
     Face_emissor e;
+    /* 
+    Candidate lists, one per tangent plane, elements lying on the same plane share a list.
+     */
+    std::vector<std::vector<Quad*>> cl;
+    std::vector<size_t> cl_i;
+    Mem_account acc;
 };
 
 #endif //QUAD_MANAGER_H
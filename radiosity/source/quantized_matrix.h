@@ -0,0 +1,156 @@
+/* date = October 19th 2026 2:05 pm */
+
+/* 
+class Quantized_matrix
+referenced by: class Radiosity, class Stimuli
+Compressed Form-Factor matrix, every entry is stored as Q fixed-point (uint16_t or uint8_t) 
+with one float scale per row:
+
+F(i,j) ~= scale(i) * q(i,j), scale(i) = max_j F(i,j) / Q_max
+
+Form-Factors are non-negative and each row sums to <= 1, so a per-row scale keeps most of 
+the precision while the solver streams 2 or 4 times fewer bytes per sweep. 
+Decompression is fused into mult_m and num_solver_gs below.
+ */
+
+#ifndef QUANTIZED_MATRIX_H
+#define QUANTIZED_MATRIX_H
+
+#include <vector>
+#include <limits>
+#include <cmath>
+#include <cstdint>
+#include "matrix.h"
+#include "mem_accounting.h"
+
+template<typename Q>
+class Quantized_matrix{
+    public:
+    Quantized_matrix(const Matrix<float,2>& m);
+    
+    float operator()(const size_t row_i, const size_t col_i)const{return scale[row_i]*q[row_i*c+col_i];}
+    size_t get_extent(size_t i)const{if(i==0)return r;if(i==1)return c;return 0;}
+    const Q* get_row(const size_t row_i)const{return q.data()+row_i*c;}
+    float get_scale(const size_t row_i)const{return scale[row_i];}
+    
+    void debug_error(const Matrix<float,2>& m, float& max_e, float& rel_e)const;
+    
+    private:
+    size_t r;
+    size_t c;
+    std::vector<Q> q;
+    std::vector<float> scale;
+    // NOTE(Alex): Always in RAM, even when the F it was built from is memory-mapped
+    Mem_account acc;
+};
+
+/* 
+Quantized_matrix Constructor
+Description:
+Quantizes m row by row, rounding to nearest. m is streamed in row blocks so a memory-mapped 
+Form-Factor matrix never becomes fully resident.
+
+Parameters: 
+const Matrix<float,2>& m: Non-negative matrix to quantize.
+
+Output: -
+ */
+template<typename Q>
+Quantized_matrix<Q>::Quantized_matrix(const Matrix<float,2>& m):
+r{m.get_extent(0)},
+c{m.get_extent(1)},
+q(r*c),
+scale(r),
+acc{mem_category::matrix, r*c*sizeof(Q) + r*sizeof(float)}
+{
+    const float q_max = float(std::numeric_limits<Q>::max());
+    size_t br = m.get_block_rows();
+    m.advise_sequential();
+    for(size_t i = 0; i < r; ++i){
+        float mx = 0.0f;
+        for(size_t j = 0; j < c; ++j) mx = std::max(mx, m(i,j));
+        scale[i] = mx / q_max;
+        float is = mx > 0.0f ? q_max / mx : 0.0f;
+        Q* qr = q.data() + i*c;
+        for(size_t j = 0; j < c; ++j){
+            float v = std::max(0.0f, m(i,j)) * is + 0.5f;
+            qr[j] = static_cast<Q>(std::min(v, q_max));
+        }
+        if((i+1)%br==0) m.release_rows(i+1-br,br);
+    }
+    m.release_rows(0,r);
+}
+
+/* 
+void Quantized_matrix<Q>::debug_error(const Matrix<float,2>& m, float& max_e, float& rel_e)const
+Description:
+Measures quantization error against the float matrix it was built from.
+
+Parameters: 
+const Matrix<float,2>& m: Float matrix.
+float& max_e: Maximum absolute entry error.
+float& rel_e: Relative Frobenius norm error, ||m - q|| / ||m||.
+
+Output: -
+ */
+template<typename Q>
+void Quantized_matrix<Q>::debug_error(const Matrix<float,2>& m, float& max_e, float& rel_e)const{
+    double se = 0.0;
+    double sm = 0.0;
+    max_e = 0.0f;
+    for(size_t i = 0; i < r; ++i){
+        for(size_t j = 0; j < c; ++j){
+            float d = m(i,j) - (*this)(i,j);
+            max_e = std::max(max_e, std::fabs(d));
+            se += double(d)*d;
+            sm += double(m(i,j))*m(i,j);
+        }
+    }
+    rel_e = sm > 0.0 ? float(std::sqrt(se/sm)) : 0.0f;
+}
+
+/* 
+Matrix<float,1> mult_m(const Quantized_matrix<Q>& m1, const Matrix<float,1>& m2)
+Description:
+Matrix-vector product with decompression fused in, the row scale is applied once per row.
+ */
+template<typename Q>
+Matrix<float,1> mult_m(const Quantized_matrix<Q>& m1, const Matrix<float,1>& m2){
+    assert(m1.get_extent(1)==m2.get_extent());
+    Matrix<float,1> res(m1.get_extent(0));
+    const float* x = m2.data();
+    for(size_t i=0;i<m1.get_extent(0);++i){
+        const Q* qr = m1.get_row(i);
+        float s{};
+        for(size_t j=0;j<m1.get_extent(1);++j){
+            s += float(qr[j])*x[j];
+        }
+        res(i) = s*m1.get_scale(i);
+    }
+    return res;
+}
+
+/* 
+void num_solver_gs(const Quantized_matrix<Q>& f, const Matrix<float,1>& p, Matrix<float,1>& x, const Matrix<float,1>& b)
+Description:
+One Gauss-Seidel sweep over (I - P F) x = b straight from quantized F, P is the diagonal 
+reflectivity vector p. K is never formed:
+
+x(i) = (b(i) + p(i) sum_{j!=i} F(i,j) x(j)) / (1 - p(i) F(i,i))
+ */
+template<typename Q>
+void num_solver_gs(const Quantized_matrix<Q>& f, const Matrix<float,1>& p, Matrix<float,1>& x, const Matrix<float,1>& b){
+    float* xd = x.data();
+    size_t n = f.get_extent(1);
+    for(size_t i=0;i<f.get_extent(0);++i){
+        const Q* qr = f.get_row(i);
+        float s{};
+        for(size_t j=0;j<i;++j) s += float(qr[j])*xd[j];
+        for(size_t j=i+1;j<n;++j) s += float(qr[j])*xd[j];
+        float sc = f.get_scale(i);
+        float ic = 1.0f/(1.0f - p(i)*sc*float(qr[i]));
+        xd[i] = (b(i) + p(i)*sc*s)*ic;
+    }
+}
+
+#endif //QUANTIZED_MATRIX_H
@@ -1,4 +1,29 @@
 #include "radiosity.h"
+#include <cmath>
+#include <iostream>
+#include "utility.h"
+#include "instrumentation.h"
+#include "trace.h"
+#include "mem_accounting.h"
+
+/* 
+Scene materials, one row per stimuli: 
+Emissivity of the area light, then reflectivity of Faces XY_Z0, YZ_X0, XZ_Y0, YZ_X5, XZ_Y5.
+ */
+static const float materials[3][6]{
+    {15.0f, 0.73f, 0.12f, 0.73f, 0.65f, 0.73f},
+    {15.0f, 0.73f, 0.45f, 0.73f, 0.05f, 0.73f},
+    {15.0f, 0.73f, 0.15f, 0.73f, 0.05f, 0.73f},
+};
+
+/* 
+Form-Factor and solver matrices larger than this are memory-mapped instead of held in RAM.
+ */
+static const size_t in_core_bytes = size_t(1) << 30;
+
+static bool is_out_of_core(size_t n){
+    return n*n*sizeof(float) > in_core_bytes;
+}
 
 /* 
 Radiosity Constructor
@@ -7,21 +32,441 @@ The radiosity solver contains three stimuli objects,
 each of them solves a system o linear equations with Form Factor 
 previously calculated by Element Objects.
 
+Nothing is built here, the pipeline runs in explicit phases: mesh, compute_form_factors and solve. 
+Each phase runs the ones before it when needed, does nothing when already done, prints how long it took and 
+returns false when cancelled (see cancel), after which it can simply be called again.
+
+Form-Factors and solved radiosities are kept in a Solution_cache keyed by a hash of the scene, 
+F is only recalculated when geometry, hps or HemiCube resolution change, and the system is only 
+solved again when materials change too. set_persistence(false) skips the cache for timing runs.
+Scenes whose n x n matrices exceed in_core_bytes keep F and K in memory-mapped scratch files.
+
+The solve runs on float F (through K) or, with fmt q16/q8, on a quantized copy of F. With fmt hmat dense F is 
+never stored: its rows stream into an H-matrix as they are cast (see h_matrix.h), so F storage stays 
+O(n log n), such solutions are not kept in the Solution_cache.
+Every phase runs on the calling thread unless set_threads gives it a pool, see set_threads.
+An observer, when given, watches the solve, see solver_observer.h, add_observer attaches more of them. 
+Cached solutions are reported as one final sweep.
+
+Parameters: 
+float fw_: Face Size Width.
+ int hps_: Hitables Per Face Side.
+ ff_format fmt_: Form-Factor storage used by the solver.
+ Solver_observer* obs_: Observer of the solve, may be null.
+
+Output: -
+ */
+Radiosity::Radiosity(float fw_, int hps_, ff_format fmt_, Solver_observer* obs_):
+fw{fw_},
+hps{hps_},
+fmt{fmt_},
+hm_x{hm_xc},
+hm_y{hm_yc},
+qm{},
+f{},
+hf{},
+r_s{0},
+g_s{0},
+b_s{0},
+fg{},
+obs{},
+pool{},
+deterministic{true},
+ff_ready{false},
+ff_cached{false},
+solved{false},
+persist{true},
+cancelled{false},
+phase_s{}
+{
+    add_observer(obs_);
+}
+
+/* 
+bool Radiosity::mesh()
+Description:
+Meshes the Cornell Box into elements.
+
+Parameters: 
+
+Output:
+bool: Whether the scene is meshed.
+ */
+bool Radiosity::mesh()
+{
+    if(qm) return true;
+    if(cancelled) return false;
+    size_t budget = mem_get_budget();
+    size_t need = estimate_bytes(hps, fmt);
+    if(budget && need > budget)
+    {
+        std::cout << "Warning: hps " << hps << " needs about " << (need >> 20) << " MiB, over the " 
+            << (budget >> 20) << " MiB memory budget" << std::endl;
+    }
+    Phase_timer t{"Mesh", phase_s[int(solver_phase::mesh)]};
+    {
+        INSTRUMENT_SCOPE("face_construction");
+        qm = std::make_unique<Quad_manager>(fw, hps);
+    }
+    qm->set_hemicube(hm_x, hm_y);
+    return true;
+}
+
+/* 
+size_t Radiosity::estimate_bytes(int hps, ff_format fmt)
+Description:
+RAM the solver needs for hps elements per face side before meshing anything: F plus the three K, 
+unless they go to memory-mapped scratch files, or F plus its quantized copy, which stays in RAM 
+even when F is mapped, plus the quads and candidate lists. With hmat only the streamed H-matrix is held, bounded by a dense copy. Frame buffers depend on the renders and are left out.
+
+Parameters: 
+int hps: Hitables Per Face Side.
+ff_format fmt: Form-Factor storage used by the solver.
+
+Output:
+size_t: Estimated bytes.
+ */
+size_t Radiosity::estimate_bytes(int hps, ff_format fmt)
+{
+    size_t n = 5*size_t(hps)*size_t(hps) + 1;
+    size_t nn = n*n;
+    size_t solver = 0;
+    switch(fmt){
+        case ff_format::f32: solver = 3*nn*sizeof(float); break;
+        case ff_format::q16: solver = nn*sizeof(uint16_t); break;
+        case ff_format::q8: solver = nn*sizeof(uint8_t); break;
+        case ff_format::hmat: solver = nn*sizeof(float); break;
+    }
+    bool quantized = fmt == ff_format::q16 || fmt == ff_format::q8;
+    size_t matrices = is_out_of_core(n) ? (quantized ? solver : 0) : nn*sizeof(float) + solver;
+    // NOTE(Alex): No dense F with hmat, only the H-matrix and the batch of rows in flight
+    if(fmt == ff_format::hmat) matrices = solver + 64*n*sizeof(float);
+    // NOTE(Alex): About one candidate list per Face plane, each holding most of the quads
+    size_t elements = n*(sizeof(Quad_XY_Z0) + 2*sizeof(std::shared_ptr<Quad>)) + 6*n*sizeof(Quad*);
+    return matrices + elements;
+}
+
+/* 
+void Radiosity::set_hemicube(int xc, int yc)
+Description:
+Sets the HemiCube resolution used for F, hm_xc x hm_yc by default. Mesh, F and B computed at another 
+resolution are dropped (vertex colors accumulate, so a new B needs fresh quads), the next phase call runs again.
+
+Parameters: 
+int xc: Cube's Pixel Count per Face width.
+int yc: Cube's Pixel Count per Face height.
+
+Output: -
+ */
+void Radiosity::set_hemicube(int xc, int yc)
+{
+    if(xc == hm_x && yc == hm_y) return;
+    hm_x = xc;
+    hm_y = yc;
+    fg.reset();
+    hf.reset();
+    qm.reset();
+    ff_ready = false;
+    solved = false;
+}
+
+/* 
+void Radiosity::set_threads(size_t tc)
+Description:
+Sets the threads F rows and residuals are computed on, 1 (the default) runs them on the calling thread. 
+Work is split in fixed jobs and reductions add their partial sums in a fixed order, so in deterministic 
+mode F and B do not depend on tc and a Solution_cache written with any tc stays valid. 
+Gauss-Seidel sweeps are serial by nature and always run on the calling thread.
+
+Parameters: 
+size_t tc: Thread count, 0 uses every hardware thread.
+
+Output: -
+ */
+void Radiosity::set_threads(size_t tc)
+{
+    if(tc == 1) pool.reset();
+    else pool = std::make_unique<Thread_pool>(tc);
+}
+
+/* 
+bool Radiosity::compute_form_factors()
+Description:
+Loads F from the Solution_cache or casts every element's hemicube, meshing first if needed. 
+With fmt hmat the rows are streamed into the H-matrix instead.
+
+Parameters: 
+
+Output:
+bool: Whether F is ready, false when cancelled.
+ */
+bool Radiosity::compute_form_factors()
+{
+    if(ff_ready) return true;
+    if(!mesh() || cancelled) return false;
+    Phase_timer t{"Form-Factors", phase_s[int(solver_phase::form_factors)]};
+    size_t n = qm->get_count();
+    if(fmt == ff_format::hmat)
+    {
+        // NOTE(Alex): Rows go straight into the H-matrix, dense F is never held
+        f = Matrix<float,2>{};
+        ff_cached = false;
+        hf = std::make_unique<H_matrix>(qm->get_face_grids(), qm->get_positions());
+        ff_ready = qm->calc_ff_rows([this](size_t i, const float* row){hf->add_row(i, row);}, &cancelled, pool.get());
+        if(ff_ready) hf->finish();
+        return ff_ready;
+    }
+    // NOTE(Alex): calc_ff accumulates, a cancelled attempt leaves F dirty
+    f = Matrix<float,2>(n, n, is_out_of_core(n));
+    Solution_cache sc{"radiosity_cache.bin"};
+    ff_cached = persist && sc.load_ff(qm->geometry_key(), f);
+    ff_ready = ff_cached || qm->calc_ff(f, &cancelled, pool.get());
+    return ff_ready;
+}
+
+/* 
+bool Radiosity::solve()
+Description:
+Loads B from the Solution_cache or solves K B = E for the three stimuli, computing F first if needed. 
+Solved radiosities are moved onto the quads, every get_ / request function needs this phase done.
+
 Parameters: 
-float fw: Face Size Width.
- int hps: Hitables Per Face Side.
+
+Output:
+bool: Whether B is solved, false when cancelled.
+ */
+bool Radiosity::solve()
+{
+    if(solved) return true;
+    if(!compute_form_factors() || cancelled) return false;
+    Phase_timer t{"Solve", phase_s[int(solver_phase::solve)]};
+    size_t n = qm->get_count();
+    uint64_t ff_key = qm->geometry_key();
+    uint64_t b_key = Fnv1a(materials, sizeof(materials), ff_key);
+    b_key = Fnv1a(&fmt, sizeof(fmt), b_key);
+    
+    // NOTE(Alex): P and E are cheap, cached solves keep them too for the final gather
+    r_s = Stimuli{n};
+    g_s = Stimuli{n};
+    b_s = Stimuli{n};
+    const float (&r_m)[6] = materials[0];
+    const float (&g_m)[6] = materials[1];
+    const float (&b_m)[6] = materials[2];
+    r_s.set_stimuli(5, hps, r_m[0], r_m[1], r_m[2], r_m[3], r_m[4], r_m[5]);
+    g_s.set_stimuli(5, hps, g_m[0], g_m[1], g_m[2], g_m[3], g_m[4], g_m[5]);
+    b_s.set_stimuli(5, hps, b_m[0], b_m[1], b_m[2], b_m[3], b_m[4], b_m[5]);
+    r_s.set_pool(pool.get(), deterministic);
+    g_s.set_pool(pool.get(), deterministic);
+    b_s.set_pool(pool.get(), deterministic);
+    
+    Solution_cache sc{"radiosity_cache.bin"};
+    for(Solver_observer* o : obs) o->on_begin(*qm);
+    if(!ff_cached || !sc.load_b(ff_key, b_key, r_s.b, g_s.b, b_s.b))
+    {
+        bool done = false;
+        switch(fmt){
+            case ff_format::f32:
+            {
+                r_s.build_k(f);
+                g_s.build_k(f);
+                b_s.build_k(f);
+                done = solve_lockstep([](Stimuli& s){return s.step();});
+            }break;
+            case ff_format::q16:
+            {
+                done = solve_quantized<uint16_t>();
+            }break;
+            case ff_format::q8:
+            {
+                done = solve_quantized<uint8_t>();
+            }break;
+            case ff_format::hmat:
+            {
+                done = solve_hierarchical();
+            }break;
+        }
+        if(!done)
+        {
+            for(Solver_observer* o : obs) o->on_end();
+            return false;
+        }
+        if(persist)
+        {
+            if(!hf) sc.store(ff_key, b_key, f, r_s.b, g_s.b, b_s.b);
+            debug_print();
+        }
+    }
+    else for(Solver_observer* o : obs) o->on_progress(0, r_s, g_s, b_s);
+    for(Solver_observer* o : obs) o->on_end();
+    
+    {
+        INSTRUMENT_SCOPE("move_radiosities");
+        qm->move_radiosities(r_s.b,g_s.b,b_s.b);
+    }
+    solved = true;
+    return true;
+}
+
+/* 
+void Radiosity::set_final_gather(int s, float a)
+Description:
+Enables the final gather pass, see final_gather.h, with s x s directions per gather and irradiance cache error a. 
+s < 1 disables it. The irradiance cache fills in thread timing order, so in deterministic mode it is off and 
+every visible point gathers, a is unused then.
+
+Parameters: 
+int s: Directions per gather side.
+float a: Irradiance cache error.
 
 Output: -
  */
-Radiosity::Radiosity(float fw, int hps):
-qm{fw,hps},
-f(qm.calc_ff()),
-r_s{5, fw, hps, f, 15.0f, 0.73f, 0.12f, 0.73f, 0.65f, 0.73f},
-g_s{5, fw, hps, f, 15.0f, 0.73f, 0.45f, 0.73f, 0.05f, 0.73f},
-b_s{5, fw, hps, f, 15.0f, 0.73f, 0.15f, 0.73f, 0.05f, 0.73f}
+void Radiosity::set_final_gather(int s, float a)
 {
+    if(s < 1)
+    {
+        fg.reset();
+        return;
+    }
+    if(!solve()) return;
+    size_t n = qm->get_count();
+    std::vector<Color<float>> b(n), p(n), e(n);
+    for(size_t i = 0; i < n; ++i){
+        b[i] = {r_s.b(i), g_s.b(i), b_s.b(i)};
+        p[i] = {r_s.p(i), g_s.p(i), b_s.p(i)};
+        e[i] = {r_s.e(i), g_s.e(i), b_s.e(i)};
+    }
+    fg = std::make_unique<Final_gather>(*qm, qm->get_width(), s, a, std::move(b), std::move(p), std::move(e));
+    fg->set_cache(!deterministic);
+}
+
+/* 
+Color<float> Radiosity::get_gathered_radiance(Ray ray, float tMin, float tMax, ElemIndex& i)
+Description:
+Final gathered radiance of the closest hit, interpolated vertex radiance when the pass is disabled.
+
+Parameters: 
+Ray ray: Ray.
+float tMin: Ray minimum collision testing boundary. 
+float tMax: Ray maximum collision testing boundary. 
+ElemIndex& i: Element index of the hit quad, -1 on a miss.
+
+Output:
+Color<float>: Radiance.
+ */
+Color<float> Radiosity::get_gathered_radiance(Ray ray, float tMin, float tMax, ElemIndex& i)
+{
+    if(!fg) return qm->get_radiance(ray, tMin, tMax, i);
+    return fg->get_radiance(ray, tMin, tMax, i);
+}
+
+/* 
+void Radiosity::solve_lockstep(const S& step)
+Description:
+Sweeps the three stimuli in turn until all of them converged, stimuli are independent so the 
+solution is the same as solving them one after the other, but partial solutions carry every channel. 
+Every observer sees its every cadence-th sweep and the converged one. Cancellation is checked between sweeps.
+
+Parameters: 
+const S& step: Callable bool(Stimuli&), one sweep of a stimuli returning whether it had converged.
+
+Output:
+bool: Whether all stimuli converged, false when cancelled.
+ */
+template<typename S>
+bool Radiosity::solve_lockstep(const S& step)
+{
+    Stimuli* s[3] = {&r_s, &g_s, &b_s};
+    bool done[3] = {false, false, false};
+    for(size_t sweep = 1;; ++sweep){
+        if(cancelled) return false;
+        for(int c = 0; c < 3; ++c){
+            if(done[c]) continue;
+            INSTRUMENT_SCOPE(c == 0 ? "solve_r" : c == 1 ? "solve_g" : "solve_b");
+            TRACE_SCOPE(c == 0 ? "sweep_r" : c == 1 ? "sweep_g" : "sweep_b");
+            done[c] = step(*s[c]);
+        }
+        bool all = done[0] && done[1] && done[2];
+        for(Solver_observer* o : obs){
+            if(all || sweep % o->cadence == 0) o->on_progress(sweep, r_s, g_s, b_s);
+        }
+        if(all)
+        {
+            INSTRUMENT_VALUE("residual_r", r_s.residual_norm);
+            INSTRUMENT_VALUE("residual_g", g_s.residual_norm);
+            INSTRUMENT_VALUE("residual_b", b_s.residual_norm);
+            return true;
+        }
+    }
+}
+
+/* 
+bool Radiosity::solve_quantized()
+Description:
+Solves the three stimuli on a Q fixed-point copy of F and reports its accuracy against the 
+float path: quantization error of F and residual of each solution under float F.
+
+Parameters: 
+
+Output:
+bool: Whether the stimuli converged, false when cancelled.
+ */
+template<typename Q>
+bool Radiosity::solve_quantized()
+{
+    Quantized_matrix<Q> qf{f};
+    if(!solve_lockstep([&qf](Stimuli& s){return s.step(qf);})) return false;
+    
+    float max_e = 0.0f;
+    float rel_e = 0.0f;
+    qf.debug_error(f, max_e, rel_e);
+    std::cout << "Quantized F (" << sizeof(Q)*8 << " bit): max error " << max_e 
+        << ", relative error " << rel_e 
+        << ", float residual r " << r_s.squared_residual(f)
+        << " g " << g_s.squared_residual(f)
+        << " b " << b_s.squared_residual(f) << std::endl;
+    return true;
+}
+
+/* 
+bool Radiosity::solve_hierarchical()
+Description:
+Solves the three stimuli on the H-matrix streamed by compute_form_factors and reports its storage 
+against the dense F it stands in for. The accuracy of the compression against dense F is measured by tools/ff_validation.
+
+Parameters: 
+
+Output:
+bool: Whether the stimuli converged, false when cancelled.
+ */
+bool Radiosity::solve_hierarchical()
+{
+    const H_matrix& h = *hf;
+    if(!solve_lockstep([&h](Stimuli& s){return s.step(h);})) return false;
+    
+    size_t n = h.get_extent(0);
+    std::cout << "H-matrix F: " << h.get_block_count() << " blocks, " << h.get_bytes() << " bytes (dense " 
+        << n*n*sizeof(float) << ", never stored)"
+        << ", residual r " << r_s.residual_norm
+        << " g " << g_s.residual_norm
+        << " b " << b_s.residual_norm << std::endl;
+    return true;
+}
+
+/* 
+void Radiosity::debug_print()const
+Description:
+Prints F and every solver matrix into PPM files, solve does it for every fresh solution while persisting.
+
+Parameters: 
+
+Output: -
+ */
+void Radiosity::debug_print()const
+{
+    TRACE_SCOPE("debug_print");
+    // NOTE(Alex): No dense F to print with hmat
     std::string FString = "F" + std::to_string(0) + "_matrix.ppm";
-    f.debug_print(FString);
+    if(f.get_extent(0)) f.debug_print(FString);
     
     {
         /* 
@@ -71,8 +516,4 @@ b_s{5, fw, hps, f, 15.0f, 0.73f, 0.15f, 0.73f, 0.05f, 0.73f}
         std::string BString = "B_b_s_matrix.ppm";
         b_s.b.debug_print(BString);
     }
-    
-    qm.move_radiosities(r_s.b,g_s.b,b_s.b);
 }
-
-
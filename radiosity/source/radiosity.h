@@ -15,17 +15,72 @@ referenced by: class Space
 #include "ray.h"
 #include "quad_manager.h"
 #include "stimuli.h"
+#include "solution_cache.h"
+#include "final_gather.h"
+#include "solver_observer.h"
+#include "thread_pool.h"
+#include <memory>
+#include <atomic>
+#include <vector>
+
+enum class solver_phase : int {mesh=0,form_factors=1,solve=2,render=3};
 
 class Radiosity{
     public:
-    Radiosity(float fw, int hps);
-    Color<int> get_color(Ray ray, float tMin, float tMax){return qm.get_color(ray, tMin, tMax);}
+    Radiosity(float fw_, int hps_, ff_format fmt_ = ff_format::f32, Solver_observer* obs_ = nullptr);
+    bool mesh();
+    bool compute_form_factors();
+    bool solve();
+    void set_hemicube(int xc, int yc);
+    static size_t estimate_bytes(int hps, ff_format fmt);
+    void add_observer(Solver_observer* o){if(o) obs.push_back(o);}
+    // NOTE(Alex): Without persistence the Solution_cache is neither loaded nor stored and no debug matrices are written
+    void set_persistence(bool p){persist = p;}
+    void debug_print()const;
+    void set_threads(size_t tc);
+    // NOTE(Alex): Deterministic (the default) keeps F, B, every residual and final gathered renders bit-identical for any thread count
+    void set_deterministic(bool d){deterministic = d; if(fg) fg->set_cache(!d);}
+    const Matrix<float,1>& get_b(int c)const{return c == 0 ? r_s.b : c == 1 ? g_s.b : b_s.b;}
+    // NOTE(Alex): Any thread may cancel, the running phase stops at its next check and later phases refuse to start
+    void cancel(){cancelled = true;}
+    void resume(){cancelled = false;}
+    bool is_solved()const{return solved;}
+    const std::atomic<bool>& get_cancel_flag()const{return cancelled;}
+    double get_phase_seconds(solver_phase p)const{return p == solver_phase::render ? 0.0 : phase_s[int(p)];}
+    Color<int> get_color(Ray ray, float tMin, float tMax){return qm->get_color(ray, tMin, tMax);}
+    Color<float> get_radiance(Ray ray, float tMin, float tMax){return qm->get_radiance(ray, tMin, tMax);}
+    Color<float> get_radiance(Ray ray, float tMin, float tMax, ElemIndex& i){return qm->get_radiance(ray, tMin, tMax, i);}
+    const std::vector<std::shared_ptr<Quad>>& get_quads()const{return qm->get_quads();}
+    std::vector<Face_grid> get_face_grids()const{return qm->get_face_grids();}
+    void set_final_gather(int s, float a);
+    Color<float> get_gathered_radiance(Ray ray, float tMin, float tMax, ElemIndex& i);
     private:
-    Quad_manager qm;
+    template<typename Q>
+        bool solve_quantized();
+    bool solve_hierarchical();
+    template<typename S>
+        bool solve_lockstep(const S& step);
+    float fw;
+    int hps;
+    ff_format fmt;
+    int hm_x;
+    int hm_y;
+    std::unique_ptr<Quad_manager> qm;
     Matrix<float,2> f;
+    std::unique_ptr<H_matrix> hf;
     Stimuli r_s;
     Stimuli g_s;
     Stimuli b_s;
+    std::unique_ptr<Final_gather> fg;
+    std::vector<Solver_observer*> obs;
+    std::unique_ptr<Thread_pool> pool;
+    bool deterministic;
+    bool ff_ready;
+    bool ff_cached;
+    std::atomic<bool> solved;
+    bool persist;
+    std::atomic<bool> cancelled;
+    double phase_s[3];
 };
 
 #endif //RADIOSITY_H
@@ -0,0 +1,199 @@
+#include "raster_projector.h"
+#include <cfloat>
+#include <cmath>
+#include <vector>
+#include <algorithm>
+#include "instrumentation.h"
+#include "trace.h"
+#include "mem_accounting.h"
+
+/* 
+Rows per band, bands are scan converted in parallel.
+ */
+static const size_t band_size = 32;
+
+/* 
+Barycentric slack, keeps shared edges from cracking due to rounding.
+ */
+static const float edge_eps = 1e-5f;
+
+/* 
+struct Raster_vertex
+Projected quad corner: Texture Coordinates on the canvas (x,y), ray parameter t and quad hit coordinates (u,v).
+ */
+struct Raster_vertex{
+    float x;
+    float y;
+    float t;
+    float u;
+    float v;
+};
+
+/* 
+struct Raster_tri
+Triangle set up for scan conversion.
+ */
+struct Raster_tri{
+    Raster_vertex p[3];
+    float ia;
+    float x0,x1,y0,y1;
+    int q;
+};
+
+/* 
+struct Fragment
+z-buffer entry, closest quad hit by the sample ray.
+ */
+struct Fragment{
+    float t;
+    int q;
+    float u;
+    float v;
+};
+
+static float edge(const Raster_vertex& a, const Raster_vertex& b, float x, float y){
+    return (b.x - a.x) * (y - a.y) - (b.y - a.y) * (x - a.x);
+}
+
+/*
+ RasterProjector::render
+Description:
+Rasterizes the ortho and perspective views of the Cornell Box.
+
+Parameters: 
+Displayable& d: Displayable to request quads from.
+float fw: Cornell Box's face width.
+ float fh: Cornell Box's face height.
+ int th: Image Height.
+ int tw: Image Width.
+
+Output: -
+ */
+void RasterProjector::render(Displayable& d, float fw, float fh, int th, int tw)
+{
+    for(const Camera& c:get_ortho_cameras(fw, fh)) render(d, c, c.name + "_raster", th, tw);
+    Camera c = get_persp_camera(fw, fh);
+    render(d, c, c.name + "_raster", th, tw);
+}
+
+/*
+ RasterProjector::render
+Description:
+Rasterizes one camera view of a displayable into a z-buffer, then shades it into the output files. 
+The z-buffer covers every canvas sample, Texture Coordinates u in [0,tw] and v in [-1,th-1], and 
+keeps the ray-cast conventions: depth is the ray parameter, hits closer than 0.001 are ignored and 
+ties go to the later quad. 
+Perspective triangles with a corner behind the eye are dropped, the Cornell Box never needs clipping.
+
+Parameters: 
+Displayable& d: Displayable to request quads from.
+const Camera& c: Camera.
+const std::string& name: Output file name without extension.
+ int th: Image Height.
+ int tw: Image Width.
+
+Output: -
+ */
+void RasterProjector::render(Displayable& d, const Camera& c, const std::string& name, int th, int tw)
+{
+    INSTRUMENT_SCOPE("render_raster");
+    Canvas canvas(c.X, c.Y, c.O, c.fw, c.fh, th, tw, c.cg);
+    const auto& quads = d.request_quads();
+    bool persp = c.type == camera_type::persp;
+    
+    // NOTE(Alex): Setup, corners in hit coordinates order (0,0) (1,0) (0,1) (1,1)
+    std::vector<Raster_tri> tris;
+    tris.reserve(quads.size()*2);
+    for(size_t i = 0; i < quads.size(); ++i){
+        Raster_vertex q[4];
+        bool visible = true;
+        for(int j = 0; j < 4 && visible; ++j){
+            float u = float(j & 1);
+            float v = float(j >> 1);
+            Vec3<float> pc{};
+            float t = 0.0f;
+            visible = c.project(quads[i]->get_point(u, v), pc, t);
+            auto xy = canvas.conv_world_to_text(pc);
+            q[j] = {std::get<0>(xy), std::get<1>(xy), t, u, v};
+        }
+        if(!visible) continue;
+        
+        const int ti[2][3] = {{0,1,3},{0,3,2}};
+        for(auto& a:ti){
+            Raster_tri r{{q[a[0]], q[a[1]], q[a[2]]}, 0.0f, 0, 0, 0, 0, static_cast<int>(i)};
+            float area = edge(r.p[0], r.p[1], r.p[2].x, r.p[2].y);
+            // NOTE(Alex): Quads parallel to the rays are never hit
+            if(std::fabs(area) < 1e-8f) continue;
+            r.ia = 1.0f / area;
+            r.x0 = std::min({r.p[0].x, r.p[1].x, r.p[2].x});
+            r.x1 = std::max({r.p[0].x, r.p[1].x, r.p[2].x});
+            r.y0 = std::min({r.p[0].y, r.p[1].y, r.p[2].y});
+            r.y1 = std::max({r.p[0].y, r.p[1].y, r.p[2].y});
+            tris.push_back(r);
+        }
+    }
+    
+    // NOTE(Alex): Scan conversion, grid row gy holds samples with v = gy - 1
+    size_t gw = size_t(tw) + 1;
+    size_t gh = size_t(th) + 1;
+    std::vector<Fragment> fb(gw*gh, Fragment{FLT_MAX, -1, 0.0f, 0.0f});
+    Mem_account fb_acc{mem_category::framebuffer, fb.size()*sizeof(Fragment)};
+    size_t bc = (gh + band_size - 1) / band_size;
+    pool.parallel_for(bc, [&](size_t b){
+        TRACE_SCOPE("raster_band");
+        int gy0 = static_cast<int>(b*band_size);
+        int gy1 = static_cast<int>(std::min(gh, (b + 1)*band_size)) - 1;
+        for(const Raster_tri& r:tris){
+            int ya = std::max(gy0, static_cast<int>(std::ceil(r.y0)) + 1);
+            int yb = std::min(gy1, static_cast<int>(std::floor(r.y1)) + 1);
+            int xa = std::max(0, static_cast<int>(std::ceil(r.x0)));
+            int xb = std::min(tw, static_cast<int>(std::floor(r.x1)));
+            for(int gy = ya; gy <= yb; ++gy){
+                float y = static_cast<float>(gy - 1);
+                for(int x = xa; x <= xb; ++x){
+                    float fx = static_cast<float>(x);
+                    float w0 = edge(r.p[1], r.p[2], fx, y) * r.ia;
+                    float w1 = edge(r.p[2], r.p[0], fx, y) * r.ia;
+                    float w2 = edge(r.p[0], r.p[1], fx, y) * r.ia;
+                    if(w0 < -edge_eps || w1 < -edge_eps || w2 < -edge_eps) continue;
+                    
+                    float t, u, v;
+                    if(persp)
+                    {
+                        // NOTE(Alex): 1/t is affine in screen space
+                        float i0 = w0 / r.p[0].t;
+                        float i1 = w1 / r.p[1].t;
+                        float i2 = w2 / r.p[2].t;
+                        t = 1.0f / (i0 + i1 + i2);
+                        u = (i0*r.p[0].u + i1*r.p[1].u + i2*r.p[2].u) * t;
+                        v = (i0*r.p[0].v + i1*r.p[1].v + i2*r.p[2].v) * t;
+                    }
+                    else
+                    {
+                        t = w0*r.p[0].t + w1*r.p[1].t + w2*r.p[2].t;
+                        u = w0*r.p[0].u + w1*r.p[1].u + w2*r.p[2].u;
+                        v = w0*r.p[0].v + w1*r.p[1].v + w2*r.p[2].v;
+                    }
+                    
+                    Fragment& f = fb[size_t(gy)*gw + size_t(x)];
+                    if(t < 0.001f || t > f.t) continue;
+                    f = {t, r.q, std::min(1.0f, std::max(0.0f, u)), std::min(1.0f, std::max(0.0f, v))};
+                }
+            }
+        }
+    });
+    
+    auto fragment = [&](size_t k)->const Fragment&{
+        auto p = canvas.get_sample_pos(k);
+        return fb[size_t(std::get<1>(p) + 1)*gw + size_t(std::get<0>(p))];
+    };
+    render_canvas(canvas, name, 
+                  [&](size_t k){
+                      const Fragment& f = fragment(k);
+                      return f.q < 0 ? Color<int>{0,0,0} : quads[f.q]->get_color(f.u, f.v);
+                  },
+                  [&](size_t k){
+                      const Fragment& f = fragment(k);
+                      return f.q < 0 ? Color<float>{0,0,0} : quads[f.q]->get_radiance(f.u, f.v);
+                  });
+}
@@ -0,0 +1,32 @@
+/* date = October 19th 2026 9:40 pm */
+
+/* 
+class RasterProjector
+Inherits From: class Projector
+Rasterizing renderer. Radiosity results are view independent Gouraud shaded quads, so instead of 
+casting one ray per sample against every quad the quads are projected through the camera, 
+scan converted as 2 triangles each into a z-buffer and shaded once per visible sample with the 
+(perspective-correct) interpolated hit coordinates, which bilinearly interpolate Quad::c[0..3].
+It renders the same cameras as OrthoProjector and PerspectiveProjector, output files get a "_raster" suffix.
+ */
+
+#ifndef RASTER_PROJECTOR_H
+#define RASTER_PROJECTOR_H
+
+#include <string>
+#include "vec3.h"
+#include "canvas.h"
+#include "camera.h"
+#include "projector.h"
+#include "displayable.h"
+
+class RasterProjector : public Projector
+{
+    public:
+    RasterProjector(size_t tc = 0):Projector{tc}{}
+    void render(Displayable& d, float fw, float fh, int th, int tw);
+    void render(Displayable& d, const Camera& c, const std::string& name, int th, int tw);
+    private:
+};
+
+#endif //RASTER_PROJECTOR_H
@@ -0,0 +1,176 @@
+#include "render_daemon.h"
+#include <sstream>
+#include <thread>
+#include <chrono>
+#include <algorithm>
+
+/* 
+Largest accepted image side, bigger requests are rejected rather than allocated.
+ */
+static const int max_side = 16384;
+
+/* 
+Render_daemon Constructor
+Description:
+Sets the named cameras up for a Cornell Box of fw x fh faces.
+
+Parameters: 
+Displayable& d_: Solved displayable to render.
+float fw: Face width.
+float fh: Face height.
+
+Output: -
+ */
+Render_daemon::Render_daemon(Displayable& d_, float fw, float fh):
+d{d_},
+cams{get_ortho_cameras(fw,fh)},
+p{},
+queue{},
+eof{false},
+m{},
+out_m{},
+cv{}
+{
+    cams.push_back(get_persp_camera(fw,fh));
+}
+
+/* 
+int Render_daemon::serve(std::istream& in, std::ostream& out)
+Description:
+Serves requests from in until "quit" or its end, answers go to out.
+
+Parameters: 
+std::istream& in: Request stream.
+std::ostream& out: Answer stream.
+
+Output:
+int: Process exit code.
+ */
+int Render_daemon::serve(std::istream& in, std::ostream& out)
+{
+    std::thread reader{[&]{read_requests(in, out);}};
+    std::vector<Request> batch;
+    for(;;){
+        {
+            std::unique_lock<std::mutex> l{m};
+            cv.wait(l, [this]{return eof || !queue.empty();});
+            if(queue.empty()) break;
+            batch.assign(std::make_move_iterator(queue.begin()), std::make_move_iterator(queue.end()));
+            queue.clear();
+        }
+        render_batch(batch, out);
+    }
+    reader.join();
+    return 0;
+}
+
+/* 
+bool Render_daemon::parse(const std::string& line, Request& r)const
+Description:
+Parses a "<camera> <width> <height> <output>" request line.
+
+Parameters: 
+const std::string& line: Request line.
+Request& r: Parsed request, the camera is renamed to the output path.
+
+Output:
+bool: Whether the line is a valid request.
+ */
+bool Render_daemon::parse(const std::string& line, Request& r)const
+{
+    std::istringstream ls{line};
+    std::string name, output, extra;
+    if(!(ls >> name >> r.tw >> r.th >> output) || (ls >> extra)) return false;
+    if(r.tw < 1 || r.th < 1 || r.tw > max_side || r.th > max_side) return false;
+    auto c = std::find_if(cams.begin(), cams.end(), [&](const Camera& x){return x.name == name;});
+    if(c == cams.end()) return false;
+    r.line = line;
+    r.c = *c;
+    // NOTE(Alex): render_cameras names files after cameras
+    r.c.name = output;
+    return true;
+}
+
+/* 
+void Render_daemon::read_requests(std::istream& in, std::ostream& out)
+Description:
+Reader thread, queues valid requests and answers invalid ones right away.
+
+Parameters: 
+std::istream& in: Request stream.
+std::ostream& out: Answer stream.
+
+Output: -
+ */
+void Render_daemon::read_requests(std::istream& in, std::ostream& out)
+{
+    std::string line;
+    while(std::getline(in, line)){
+        if(!line.empty() && line.back() == '\r') line.pop_back();
+        if(line.empty()) continue;
+        if(line == "quit") break;
+        Request r{};
+        if(!parse(line, r))
+        {
+            std::lock_guard<std::mutex> l{out_m};
+            out << "error " << line << std::endl;
+            continue;
+        }
+        {
+            std::lock_guard<std::mutex> l{m};
+            queue.push_back(std::move(r));
+        }
+        cv.notify_one();
+    }
+    {
+        std::lock_guard<std::mutex> l{m};
+        eof = true;
+    }
+    cv.notify_one();
+}
+
+/* 
+void Render_daemon::render_batch(std::vector<Request>& batch, std::ostream& out)
+Description:
+Renders every request of a batch, one render_cameras call per resolution. Requests writing an 
+output already taken in the current call wait for the next one, camera names MUST be unique there. 
+Requests whose output could not be opened or written are answered with err instead of ok.
+
+Parameters: 
+std::vector<Request>& batch: Requests, emptied on return.
+std::ostream& out: Answer stream.
+
+Output: -
+ */
+void Render_daemon::render_batch(std::vector<Request>& batch, std::ostream& out)
+{
+    while(!batch.empty()){
+        auto t0 = std::chrono::steady_clock::now();
+        int tw = batch.front().tw;
+        int th = batch.front().th;
+        std::vector<Camera> views;
+        std::vector<Request> done, rest;
+        for(Request& r : batch){
+            bool taken = std::any_of(views.begin(), views.end(), [&](const Camera& c){return c.name == r.c.name;});
+            if(r.tw != tw || r.th != th || taken)
+            {
+                rest.push_back(std::move(r));
+                continue;
+            }
+            views.push_back(r.c);
+            done.push_back(std::move(r));
+        }
+        std::vector<bool> written;
+        p.render_cameras(d, views, th, tw, &written);
+        
+        long long ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - t0).count();
+        {
+            std::lock_guard<std::mutex> l{out_m};
+            for(size_t i = 0; i < done.size(); ++i){
+                if(written[i]) out << "ok " << done[i].c.name << " " << ms << std::endl;
+                else out << "err " << done[i].c.name << " unable to write the output" << std::endl;
+            }
+        }
+        batch = std::move(rest);
+    }
+}
@@ -0,0 +1,62 @@
+/* date = October 20th 2026 2:15 pm */
+
+/* 
+class Render_daemon
+referenced by: main.cpp
+Keeps a solved Displayable resident and serves render requests, so a render costs only its ray casting 
+instead of meshing, Form-Factors and solve in a fresh process every time.
+
+Requests are text lines read from a stream, usually stdin fed by a pipe:
+
+    <camera> <width> <height> <output>
+
+camera is one of the get_ortho_cameras / get_persp_camera names (XY_Z0, ..., Radiosity), output is the 
+path the image is written to without ".ppm". "quit", or the end of the stream, stops the daemon once 
+queued requests are done. Every request is answered with one line: "ok <output> <ms>" once written, 
+"err <output> <reason>" when the output could not be written (e.g. an unwritable path), or "error <request>" 
+when the line is not a valid request. Answers are the only lines written to the answer stream, main sends 
+its own stdout there and moves every diagnostic printed to std::cout over to stderr in daemon mode.
+
+A reader thread queues requests as they arrive. The render thread takes everything queued at once and renders 
+requests of equal resolution in a single Projector::render_cameras batch, so requests in flight together share 
+the pool tile by tile and a lone request still uses every worker.
+ */
+
+#ifndef RENDER_DAEMON_H
+#define RENDER_DAEMON_H
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include "camera.h"
+#include "projector.h"
+#include "displayable.h"
+
+class Render_daemon{
+    public:
+    Render_daemon(Displayable& d_, float fw, float fh);
+    int serve(std::istream& in, std::ostream& out);
+    private:
+    struct Request{
+        std::string line;
+        Camera c;
+        int tw;
+        int th;
+    };
+    bool parse(const std::string& line, Request& r)const;
+    void read_requests(std::istream& in, std::ostream& out);
+    void render_batch(std::vector<Request>& batch, std::ostream& out);
+    Displayable& d;
+    std::vector<Camera> cams;
+    Projector p;
+    std::deque<Request> queue;
+    bool eof;
+    std::mutex m;
+    std::mutex out_m;
+    std::condition_variable cv;
+};
+
+#endif //RENDER_DAEMON_H
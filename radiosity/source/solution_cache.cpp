@@ -0,0 +1,133 @@
+#include "solution_cache.h"
+#include <cstring>
+#include "trace.h"
+
+static const char cache_magic[4]{'R','A','D','C'};
+static const uint32_t cache_version = 1;
+
+/* 
+Solution_cache Constructor
+Description:
+Maps the cache file if present, a missing or unreadable file is an empty cache.
+
+Parameters: 
+const std::string& fn_: Cache FileName.
+
+Output: -
+ */
+Solution_cache::Solution_cache(const std::string& fn_):
+fn{fn_},
+mf{}
+{
+    mf.open_read(fn);
+}
+
+/* 
+const Solution_cache_header* Solution_cache::get_header(uint64_t ff_key)
+Description:
+Validates magic, version, ff_key and file size of the mapped cache.
+
+Parameters: 
+uint64_t ff_key: Hash of geometry, hps and HemiCube resolution.
+
+Output:
+const Solution_cache_header*: Header of a valid cache, nullptr otherwise.
+ */
+const Solution_cache_header* Solution_cache::get_header(uint64_t ff_key){
+    if(!mf.is_open() || mf.get_size() < sizeof(Solution_cache_header)) return nullptr;
+    auto h = static_cast<const Solution_cache_header*>(mf.get_data());
+    if(std::memcmp(h->magic, cache_magic, sizeof(cache_magic)) != 0 ||
+       h->version != cache_version ||
+       h->ff_key != ff_key) return nullptr;
+    uint64_t n = h->n;
+    if(mf.get_size() != sizeof(Solution_cache_header) + (n*n + 3*n)*sizeof(float)) return nullptr;
+    return h;
+}
+
+/* 
+bool Solution_cache::load_ff(uint64_t ff_key, Matrix<float,2>& f)
+Description:
+Loads Form-Factor matrix from the cache.
+
+Parameters: 
+uint64_t ff_key: Hash of geometry, hps and HemiCube resolution.
+Matrix<float,2>& f: Form-Factor matrix to be filled in, it MUST be sized n x n.
+
+Output:
+bool: Whether the cache holds F for this key.
+ */
+bool Solution_cache::load_ff(uint64_t ff_key, Matrix<float,2>& f){
+    auto h = get_header(ff_key);
+    if(!h || h->n != f.get_extent(0) || h->n != f.get_extent(1)) return false;
+    auto src = reinterpret_cast<const float*>(h + 1);
+    std::memcpy(f.data(), src, h->n*h->n*sizeof(float));
+    return true;
+}
+
+/* 
+bool Solution_cache::load_b(uint64_t ff_key, uint64_t b_key, Matrix<float,1>& r, Matrix<float,1>& g, Matrix<float,1>& b)
+Description:
+Loads solved radiosity vectors from the cache.
+
+Parameters: 
+uint64_t ff_key: Hash of geometry, hps and HemiCube resolution.
+uint64_t b_key: Hash of ff_key and materials.
+Matrix<float,1>& r: Radiosity vector for red channel, it MUST be sized n.
+Matrix<float,1>& g: Radiosity vector for green channel, it MUST be sized n.
+Matrix<float,1>& b: Radiosity vector for blue channel, it MUST be sized n.
+
+Output:
+bool: Whether the cache holds the solution for this key.
+ */
+bool Solution_cache::load_b(uint64_t ff_key, uint64_t b_key, Matrix<float,1>& r, Matrix<float,1>& g, Matrix<float,1>& b){
+    auto h = get_header(ff_key);
+    if(!h || h->b_key != b_key || h->n != r.get_extent() || h->n != g.get_extent() || h->n != b.get_extent()) return false;
+    auto src = reinterpret_cast<const float*>(h + 1) + h->n*h->n;
+    std::memcpy(r.data(), src, h->n*sizeof(float));
+    std::memcpy(g.data(), src + h->n, h->n*sizeof(float));
+    std::memcpy(b.data(), src + 2*h->n, h->n*sizeof(float));
+    return true;
+}
+
+/* 
+bool Solution_cache::store(...)
+Description:
+Writes a new cache file, replacing the mapped one.
+
+Parameters: 
+uint64_t ff_key: Hash of geometry, hps and HemiCube resolution.
+uint64_t b_key: Hash of ff_key and materials.
+const Matrix<float,2>& f: Form-Factor matrix.
+const Matrix<float,1>& r: Radiosity vector for red channel.
+const Matrix<float,1>& g: Radiosity vector for green channel.
+const Matrix<float,1>& b: Radiosity vector for blue channel.
+
+Output:
+bool: Whether the file got written.
+ */
+bool Solution_cache::store(uint64_t ff_key, uint64_t b_key, const Matrix<float,2>& f, 
+                           const Matrix<float,1>& r, const Matrix<float,1>& g, const Matrix<float,1>& b){
+    TRACE_SCOPE("store_cache");
+    mf.close();
+    std::ofstream ofs;
+    ofs.open(fn, std::ios::trunc | std::ios::out | std::ios::binary);
+    if(!ofs.is_open())
+    {
+        std::cout << "Unable to open file:" << fn << std::endl;
+        return false;
+    }
+    uint64_t n = f.get_extent(0);
+    Solution_cache_header h{};
+    std::memcpy(h.magic, cache_magic, sizeof(cache_magic));
+    h.version = cache_version;
+    h.ff_key = ff_key;
+    h.b_key = b_key;
+    h.n = n;
+    ofs.write(reinterpret_cast<const char*>(&h), sizeof(h));
+    ofs.write(reinterpret_cast<const char*>(f.data()), n*n*sizeof(float));
+    ofs.write(reinterpret_cast<const char*>(r.data()), n*sizeof(float));
+    ofs.write(reinterpret_cast<const char*>(g.data()), n*sizeof(float));
+    ofs.write(reinterpret_cast<const char*>(b.data()), n*sizeof(float));
+    ofs.close();
+    return ofs.good();
+}
@@ -0,0 +1,49 @@
+/* date = October 19th 2026 9:40 am */
+
+/* 
+class Solution_cache
+referenced by: class Radiosity
+Persistent on-disk cache of the Form-Factor matrix and the solved radiosity vectors.
+
+The file holds two keys, ff_key hashes everything F depends on (geometry, hps, HemiCube resolution) 
+and b_key additionally hashes the materials. F is reused while ff_key matches, the solve is skipped 
+while b_key matches as well. The file is read through a memory mapping.
+
+Layout:
+Solution_cache_header
+float F[n*n]
+float B_r[n]
+float B_g[n]
+float B_b[n]
+ */
+
+#ifndef SOLUTION_CACHE_H
+#define SOLUTION_CACHE_H
+
+#include <string>
+#include <cstdint>
+#include "matrix.h"
+#include "mapped_file.h"
+
+struct Solution_cache_header{
+    char magic[4];
+    uint32_t version;
+    uint64_t ff_key;
+    uint64_t b_key;
+    uint64_t n;
+};
+
+class Solution_cache{
+    public:
+    Solution_cache(const std::string& fn);
+    bool load_ff(uint64_t ff_key, Matrix<float,2>& f);
+    bool load_b(uint64_t ff_key, uint64_t b_key, Matrix<float,1>& r, Matrix<float,1>& g, Matrix<float,1>& b);
+    bool store(uint64_t ff_key, uint64_t b_key, const Matrix<float,2>& f, 
+               const Matrix<float,1>& r, const Matrix<float,1>& g, const Matrix<float,1>& b);
+    private:
+    const Solution_cache_header* get_header(uint64_t ff_key);
+    std::string fn;
+    Mapped_file mf;
+};
+
+#endif //SOLUTION_CACHE_H
@@ -0,0 +1,32 @@
+/* date = October 20th 2026 10:05 am */
+
+/* 
+class Solver_observer
+referenced by: class Radiosity
+Derived Classes: class Preview_renderer, class Convergence_log
+Watches a solve in progress. Radiosity sweeps the three stimuli in lockstep and every cadence sweeps, 
+and once more when all of them converged, hands the current B and residual of each stimuli to on_progress. 
+on_begin is called once the scene is meshed and before the first sweep, on_end after the last one.
+Every call is made from the solving thread, so observers that do real work must hand it off. 
+Several observers may watch one solve, each on its own cadence.
+ */
+
+#ifndef SOLVER_OBSERVER_H
+#define SOLVER_OBSERVER_H
+
+#include <cstddef>
+#include "stimuli.h"
+
+class Quad_manager;
+
+class Solver_observer{
+    public:
+    Solver_observer(size_t cadence_ = 1):cadence{cadence_ ? cadence_ : 1}{}
+    virtual ~Solver_observer(){}
+    virtual void on_begin(const Quad_manager&){}
+    virtual void on_progress(size_t sweep, const Stimuli& r, const Stimuli& g, const Stimuli& b) = 0;
+    virtual void on_end(){}
+    size_t cadence;
+};
+
+#endif //SOLVER_OBSERVER_H
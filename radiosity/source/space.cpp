@@ -1,21 +1,49 @@
 #include "space.h"
+#include "utility.h"
 
 /* 
 Space Constructor
 Description:
-Simple Space constructor passes parameter values onto Radiosity solver.
+Simple Space constructor passes parameter values onto Radiosity solver, nothing is computed until a phase runs.
 
 Parameters: 
 float fw: Cornell-Box Face width.
 int hps: Cornell-Box Elements Per Face Side.
+ff_format fmt: Form-Factor storage used by the solver.
+Solver_observer* obs: Observer of the solve, may be null.
 
 Output: -
  */
-Space::Space(float fw, int hps):
-r{fw,hps}
+Space::Space(float fw, int hps, ff_format fmt, Solver_observer* obs):
+r{fw,hps,fmt,obs},
+render_s{0.0}
 {
 }
 
+/* 
+bool Space::render(Projector& p, const std::vector<Camera>& cams, int th, int tw)
+Description:
+Renders cameras with a rendering system, solving first if needed.
+
+Parameters: 
+Projector& p: Rendering system.
+const std::vector<Camera>& cams: Cameras, names MUST be unique.
+int th: Image Height.
+int tw: Image Width.
+
+Output:
+bool: Whether every view was rendered, false when cancelled.
+ */
+bool Space::render(Projector& p, const std::vector<Camera>& cams, int th, int tw)
+{
+    if(!solve() || r.get_cancel_flag()) return false;
+    Phase_timer t{"Render", render_s};
+    p.set_cancel(&r.get_cancel_flag());
+    bool done = p.render_cameras(*this, cams, th, tw);
+    p.set_cancel(nullptr);
+    return done;
+}
+
 /* 
 Color<int> Space::request_color(Ray ray, float tMin, float tMax)
 Description:
@@ -31,5 +59,121 @@ Color<int>: Color requested by rendering system.
  */
 Color<int> Space::request_color(Ray ray, float tMin, float tMax)
 {
+    if(!ensure_solved()) return {0,0,0};
     return r.get_color(ray, tMin, tMax);
 }
+
+
+/* 
+Color<float> Space::request_radiance(Ray ray, float tMin, float tMax)
+Description:
+Request unclipped floating point radiance to Space object, for HDR rendering systems.
+
+Parameters: 
+Ray ray: Ray generated by rendering system to get color data.
+float tMin: Ray minimum collision testing boundary. 
+float tMax: Ray maximum collision testing boundary. 
+
+Output:
+Color<float>: Radiance requested by rendering system.
+ */
+Color<float> Space::request_radiance(Ray ray, float tMin, float tMax)
+{
+    if(!ensure_solved()) return {0,0,0};
+    return r.get_radiance(ray, tMin, tMax);
+}
+
+
+/* 
+Color<float> Space::request_radiance(Ray ray, float tMin, float tMax, ElemIndex& i)
+Description:
+Like request_radiance, also returns the element index of the hit quad so rendering systems can find edges.
+
+Parameters: 
+Ray ray: Ray generated by rendering system to get color data.
+float tMin: Ray minimum collision testing boundary. 
+float tMax: Ray maximum collision testing boundary. 
+ElemIndex& i: Element index of the hit quad, -1 on a miss.
+
+Output:
+Color<float>: Radiance requested by rendering system.
+ */
+Color<float> Space::request_radiance(Ray ray, float tMin, float tMax, ElemIndex& i)
+{
+    i = -1;
+    if(!ensure_solved()) return {0,0,0};
+    return r.get_radiance(ray, tMin, tMax, i);
+}
+
+/* 
+Color<float> Space::request_gathered_radiance(Ray ray, float tMin, float tMax, ElemIndex& i)
+Description:
+Final gathered radiance, see Radiosity::set_final_gather.
+
+Parameters: 
+Ray ray: Ray generated by rendering system to get color data.
+float tMin: Ray minimum collision testing boundary. 
+float tMax: Ray maximum collision testing boundary. 
+ElemIndex& i: Element index of the hit quad, -1 on a miss.
+
+Output:
+Color<float>: Radiance requested by rendering system.
+ */
+Color<float> Space::request_gathered_radiance(Ray ray, float tMin, float tMax, ElemIndex& i)
+{
+    i = -1;
+    if(!ensure_solved()) return {0,0,0};
+    return r.get_gathered_radiance(ray, tMin, tMax, i);
+}
+
+/* 
+const std::vector<std::shared_ptr<Quad>>& Space::request_quads()const
+Description:
+Solved quads for rasterizing systems.
+
+Parameters: 
+
+Output:
+const std::vector<std::shared_ptr<Quad>>&: Quads, empty when the Space can not be solved.
+ */
+const std::vector<std::shared_ptr<Quad>>& Space::request_quads()const
+{
+    static const std::vector<std::shared_ptr<Quad>> none{};
+    if(!ensure_solved()) return none;
+    return r.get_quads();
+}
+
+/* 
+std::vector<Face_grid> Space::request_face_grids()const
+Description:
+Element index layout of every Face.
+
+Parameters: 
+
+Output:
+std::vector<Face_grid>: One grid per Face, empty when the Space can not be solved.
+ */
+std::vector<Face_grid> Space::request_face_grids()const
+{
+    if(!ensure_solved()) return {};
+    return r.get_face_grids();
+}
+
+/* 
+bool Space::ensure_solved()const
+Description:
+Runs the missing phases before the first request, so any rendering system may be handed a Space that was 
+never meshed. Requests come from many render threads at once: the first one solves under phase_m while the 
+others wait on it, once solved the check is a single atomic load.
+
+Parameters: 
+
+Output:
+bool: Whether the Space is solved, false when cancelled.
+ */
+bool Space::ensure_solved()const
+{
+    if(r.is_solved()) return true;
+    std::lock_guard<std::mutex> l{phase_m};
+    return r.solve();
+}
@@ -12,23 +12,56 @@ The Space Object is the interface to the radiosity solver, it inherits from Disp
 Rendering requests from multiple rendering systems. 
 e.g. I have two Rendering systems in main.cpp that can request color data to space using request_color function.
 PerspectiveProjector and OrthoProjector.
+
+Constructing a Space is free, the pipeline runs lazily in phases: mesh, compute_form_factors, solve and render, 
+every phase runs the missing ones before it, see class Radiosity. Request functions need solve done, 
+render does it first and so does the first request of any other rendering system (see ensure_solved), 
+a Space that can not be solved (cancelled) answers black and no quads. cancel stops the running phase from 
+any thread, including render tiles.
 */
 
 #include <vector>
 #include <memory>
+#include <mutex>
 
 #include "displayable.h"
 #include "ray.h"
 #include "radiosity.h"
+#include "projector.h"
+#include "camera.h"
 
 class Space : public Displayable
 {
     public:
-    Space(float fw, int hps);
+    Space(float fw, int hps, ff_format fmt = ff_format::f32, Solver_observer* obs = nullptr);
+    bool mesh(){std::lock_guard<std::mutex> l{phase_m}; return r.mesh();}
+    bool compute_form_factors(){std::lock_guard<std::mutex> l{phase_m}; return r.compute_form_factors();}
+    bool solve(){std::lock_guard<std::mutex> l{phase_m}; return r.solve();}
+    void set_hemicube(int xc, int yc){r.set_hemicube(xc, yc);}
+    void add_observer(Solver_observer* o){r.add_observer(o);}
+    void set_persistence(bool p){r.set_persistence(p);}
+    void set_threads(size_t tc){r.set_threads(tc);}
+    void set_deterministic(bool d){r.set_deterministic(d);}
+    void debug_print()const{r.debug_print();}
+    const Matrix<float,1>& get_b(int c)const{return r.get_b(c);}
+    bool render(Projector& p, const std::vector<Camera>& cams, int th, int tw);
+    void cancel(){r.cancel();}
+    void resume(){r.resume();}
+    double get_phase_seconds(solver_phase p)const{return p == solver_phase::render ? render_s : r.get_phase_seconds(p);}
     // NOTE(Alex): Displayable override
     Color<int> request_color(Ray r, float tMin, float tMax) override;
+    Color<float> request_radiance(Ray r, float tMin, float tMax) override;
+    Color<float> request_radiance(Ray r, float tMin, float tMax, ElemIndex& i) override;
+    Color<float> request_gathered_radiance(Ray ray, float tMin, float tMax, ElemIndex& i) override;
+    void set_final_gather(int s, float a){r.set_final_gather(s, a);}
+    const std::vector<std::shared_ptr<Quad>>& request_quads()const override;
+    std::vector<Face_grid> request_face_grids()const override;
     private:
-    Radiosity r;
+    bool ensure_solved()const;
+    // NOTE(Alex): Mutable so const requests can run the phases lazily, phase_m serializes every phase call
+    mutable Radiosity r;
+    mutable std::mutex phase_m;
+    double render_s;
 };
 
 
@@ -1,15 +1,135 @@
 #include "stimuli.h"
+#include "instrumentation.h"
+#include "thread_pool.h"
+#include <cmath>
+#include <vector>
+#include <algorithm>
+
+// NOTE(Alex): Fixed sizes, never derived from the thread count, so any pool splits the work the same way
+static const size_t rows_per_job = 64;
+static const size_t sum_block = 1024;
+
+static float max_abs_diff(const Matrix<float,1>& a, const Matrix<float,1>& b)
+{
+    float m = 0.0f;
+    for(size_t i = 0; i < a.get_extent(); ++i) m = std::max(m, std::abs(a(i) - b(i)));
+    return m;
+}
+
+/* 
+static void for_rows(Thread_pool* pool, size_t r0, size_t r1, const R& row)
+Description:
+Runs row(i) for every i in [r0,r1), in jobs of rows_per_job rows on the pool or in order on the calling thread.
+
+Parameters: 
+Thread_pool* pool: Pool, may be null.
+size_t r0: First row.
+size_t r1: One past the last row.
+const R& row: Callable void(size_t), MUST only write row i.
+
+Output: -
+ */
+template<typename R>
+static void for_rows(Thread_pool* pool, size_t r0, size_t r1, const R& row)
+{
+    if(!pool)
+    {
+        for(size_t i = r0; i < r1; ++i) row(i);
+        return;
+    }
+    size_t jc = (r1 - r0 + rows_per_job - 1) / rows_per_job;
+    pool->parallel_for(jc, [&](size_t j){
+        size_t e = std::min(r1, r0 + (j + 1)*rows_per_job);
+        for(size_t i = r0 + j*rows_per_job; i < e; ++i) row(i);
+    });
+}
+
+/* 
+static void residual_k(Thread_pool* pool, const Matrix<float,2>& k, const Matrix<float,1>& b, const Matrix<float,1>& e, Matrix<float,1>& r)
+Description:
+R = E - K B, row by row in blocks of K's block rows so a memory-mapped K keeps a bounded resident footprint. 
+Every row is summed in column order, the same result as sub_m(e,mult_m(k,b)).
+
+Parameters: 
+Thread_pool* pool: Pool, may be null.
+const Matrix<float,2>& k: K.
+const Matrix<float,1>& b: B.
+const Matrix<float,1>& e: E.
+Matrix<float,1>& r: Residual.
+
+Output: -
+ */
+static void residual_k(Thread_pool* pool, const Matrix<float,2>& k, const Matrix<float,1>& b, const Matrix<float,1>& e, Matrix<float,1>& r)
+{
+    size_t n = k.get_extent(0);
+    size_t br = k.get_block_rows();
+    k.advise_sequential();
+    for(size_t r0 = 0; r0 < n; r0 += br){
+        size_t r1 = std::min(n, r0 + br);
+        for_rows(pool, r0, r1, [&](size_t i){
+            float s{};
+            for(size_t j = 0; j < n; ++j) s += k(i,j)*b(j);
+            r(i) = e(i) - s;
+        });
+        k.release_rows(r0, r1 - r0);
+    }
+}
+
+/* 
+static void residual_q(Thread_pool* pool, const Quantized_matrix<Q>& f, const Stimuli& s, Matrix<float,1>& r)
+Description:
+R = E - B + P (F B) on quantized F, every row summed in column order as mult_m does.
+
+Parameters: 
+Thread_pool* pool: Pool, may be null.
+const Quantized_matrix<Q>& f: Quantized Form-Factor matrix.
+const Stimuli& s: P, E and B.
+Matrix<float,1>& r: Residual.
+
+Output: -
+ */
+template<typename Q>
+static void residual_q(Thread_pool* pool, const Quantized_matrix<Q>& f, const Stimuli& s, Matrix<float,1>& r)
+{
+    const float* x = s.b.data();
+    for_rows(pool, 0, s.n, [&](size_t i){
+        const Q* qr = f.get_row(i);
+        float d{};
+        for(size_t j = 0; j < f.get_extent(1); ++j) d += float(qr[j])*x[j];
+        r(i) = s.e(i) - s.b(i) + s.p(i)*(d*f.get_scale(i));
+    });
+}
 
 /* 
  Stimuli Constructor
 Description:
-Stimuli object solves K B = E using pre-calculated Form-Factor data as input.
-The solver uses Gauss-Seidel. NOTE: Look at matrix.h for Gauss-Seidel Solver.
+Constructs an unsolved Stimuli object, b may be filled in by solve or straight from a Solution_cache.
+Parameters: 
+size_t n_: Element Count.
+
+Output: -
+ */
+Stimuli::Stimuli(size_t n_):
+n{n_},
+b(n),
+residual(n),
+residual_norm{0.0f},
+max_delta{0.0f},
+p{},
+e{},
+k{},
+pool{},
+deterministic{true}
+{
+}
+
+/* 
+void Stimuli::set_stimuli(int fc, int hps, float e_s, float f0_s, float f1_s, float f2_s, float f3_s, float f4_s)
+Description:
+Sets the reflectivity diagonal P and emission vector E of K B = E.
 Parameters: 
 int fc: FaceCount - 5 for Cornell Box scene. 
-float fw: FaceWidth
 int hps: Hitables Per Face Side.
-const Matrix<float:2>& f: Form-Factor matrix previously pre-calculated.
 float e_s: Average Emissivity value for Element N-1. This is the area light in Cornell-Box.
 float f0_s: Reflectivity value for Face XY_Z0
 float f1_s: Reflectivity value for Face YZ_X0
@@ -19,17 +139,10 @@ float f4_s: Reflectivity value for Face XZ_Y5
 
 Output: -
  */
-Stimuli::Stimuli(int fc, float fw, int hps, const Matrix<float,2>& f, float e_s, float f0_s, float f1_s, float f2_s, float f3_s, float f4_s):
-n{f.get_extent(0)},
-b(n),
-residual(n),
-p(n,n),
-k(n,n)
+void Stimuli::set_stimuli(int fc, int hps, float e_s, float f0_s, float f1_s, float f2_s, float f3_s, float f4_s)
 {
     int hpf=hps*hps;
     Matrix<float,1> vp(n);
-    Matrix<float,1> e(n);
-    Matrix<float,2> m(n,n);
     for (size_t fi = 0; fi < fc; fi += 1){
         for(size_t i = 0; i < hps; i += 1){
             for(size_t j = 0; j < hps; j += 1){
@@ -59,15 +172,187 @@ k(n,n)
             }
         }
     }
+    e = Matrix<float,1>(n);
     e(n-1)=e_s;
-    m.make_identity();
-    p.make_diagonal(vp);
-    k= sub_m(m,mult_m(p, f));
-    for(;;){
-        residual=sub_m(e,mult_m(k,b));
-        float norm = residual.squared_norm();
-        if(norm < 0.1f)
-            break;
-        num_solver_gs(k, b, e);
+    p = vp;
+}
+
+/* 
+void Stimuli::solve(const Matrix<float,2>& f)
+Description:
+Solves K B = E using pre-calculated Form-Factor data as input, set_stimuli MUST be called first.
+The solver uses Gauss-Seidel. NOTE: Look at matrix.h for Gauss-Seidel Solver.
+Parameters: 
+const Matrix<float:2>& f: Form-Factor matrix previously pre-calculated.
+
+Output: -
+ */
+void Stimuli::solve(const Matrix<float,2>& f)
+{
+    build_k(f);
+    while(!step()){}
+}
+
+/* 
+void Stimuli::build_k(const Matrix<float,2>& f)
+Description:
+Builds K for step(), set_stimuli MUST be called first.
+K is stored the same way as F, in memory or memory-mapped for out-of-core scenes.
+Parameters: 
+const Matrix<float:2>& f: Form-Factor matrix previously pre-calculated.
+
+Output: -
+ */
+void Stimuli::build_k(const Matrix<float,2>& f)
+{
+    INSTRUMENT_SCOPE("k_assembly");
+    /* 
+    K = I - P F, P is diagonal so K is built row by row straight from F 
+    instead of through a dense matrix product.
+     */
+    k = Matrix<float,2>(n,n,f.is_mapped());
+    size_t br = f.get_block_rows();
+    f.advise_sequential();
+    for(size_t i = 0; i < n; ++i){
+        for(size_t j = 0; j < n; ++j){
+            k(i,j) = (i == j ? 1.0f : 0.0f) - p(i)*f(i,j);
+        }
+        if((i+1)%br==0)
+        {
+            f.release_rows(i+1-br,br);
+            k.release_rows(i+1-br,br);
+        }
+    }
+    f.release_rows(0,n);
+    k.release_rows(0,n);
+}
+
+/* 
+bool Stimuli::step()
+Description:
+One Gauss-Seidel iteration on K built by build_k, unless B already converged.
+Parameters: 
+
+Output:
+bool: Whether B had converged, B is left untouched then.
+ */
+bool Stimuli::step()
+{
+    residual_k(pool, k, b, e, residual);
+    residual_norm = squared_norm(residual);
+    max_delta = 0.0f;
+    if(residual_norm < 0.1f)
+        return true;
+    Matrix<float,1> prev = b;
+    num_solver_gs(k, b, e);
+    max_delta = max_abs_diff(b, prev);
+    INSTRUMENT_COUNT(gs_sweeps, 1);
+    return false;
+}
+
+/* 
+bool Stimuli::step_q(const Quantized_matrix<Q>& f)
+Description:
+Solves K B = E straight from a quantized Form-Factor matrix, K is never formed. 
+Residual and Gauss-Seidel sweeps decompress F on the fly: R = E - B + P (F B).
+Parameters: 
+const Quantized_matrix<Q>& f: Quantized Form-Factor matrix.
+
+Output:
+bool: Whether B had converged.
+ */
+template<typename Q>
+bool Stimuli::step_q(const Quantized_matrix<Q>& f)
+{
+    residual_q(pool, f, *this, residual);
+    residual_norm = squared_norm(residual);
+    max_delta = 0.0f;
+    if(residual_norm < 0.1f)
+        return true;
+    Matrix<float,1> prev = b;
+    num_solver_gs(f, p, b, e);
+    max_delta = max_abs_diff(b, prev);
+    INSTRUMENT_COUNT(gs_sweeps, 1);
+    return false;
+}
+
+bool Stimuli::step(const Quantized_matrix<uint16_t>& f){return step_q(f);}
+bool Stimuli::step(const Quantized_matrix<uint8_t>& f){return step_q(f);}
+
+/* 
+bool Stimuli::step(const H_matrix& f)
+Description:
+One iteration of K B = E on an H-matrix, which has no cheap row access for Gauss-Seidel, so the solver 
+is Jacobi on B = E + P F B driven by the fast H-matrix product: B += R with R = E - B + P (F B).
+Reflectivities are below 1 and F rows sum to at most 1, so the iteration converges.
+Parameters: 
+const H_matrix& f: H-matrix Form-Factors.
+
+Output:
+bool: Whether B had converged.
+ */
+bool Stimuli::step(const H_matrix& f)
+{
+    Matrix<float,1> fb = mult_m(f,b);
+    for(size_t i = 0; i < n; ++i) residual(i) = e(i) - b(i) + p(i)*fb(i);
+    residual_norm = squared_norm(residual);
+    max_delta = 0.0f;
+    if(residual_norm < 0.1f)
+        return true;
+    for(size_t i = 0; i < n; ++i){
+        b(i) += residual(i);
+        max_delta = std::max(max_delta, std::abs(residual(i)));
     }
-}
\ No newline at end of file
+    INSTRUMENT_COUNT(gs_sweeps, 1);
+    return false;
+}
+
+/* 
+float Stimuli::squared_residual(const Matrix<float,2>& f)const
+Description:
+Squared norm of E - K B measured against float Form-Factors, it reports how far a solution 
+obtained from quantized F is from satisfying the float system.
+Parameters: 
+const Matrix<float:2>& f: Float Form-Factor matrix.
+
+Output:
+float: Squared residual norm.
+ */
+float Stimuli::squared_residual(const Matrix<float,2>& f)const
+{
+    Matrix<float,1> fb = mult_m(f,b);
+    Matrix<float,1> r(n);
+    for(size_t i = 0; i < n; ++i) r(i) = e(i) - b(i) + p(i)*fb(i);
+    return squared_norm(r);
+}
+
+/* 
+float Stimuli::squared_norm(const Matrix<float,1>& v)const
+Description:
+Squared norm as an ordered reduction: v is cut in blocks, each block is summed in index order and the block 
+sums are added in block order. Deterministic blocks are sum_block long whatever the pool, so the norm only 
+depends on v, a non-deterministic pool gets one block per thread. Up to sum_block elements this equals the plain serial sum.
+Parameters: 
+const Matrix<float,1>& v: Vector.
+
+Output:
+float: Squared norm.
+ */
+float Stimuli::squared_norm(const Matrix<float,1>& v)const
+{
+    size_t vn = v.get_extent();
+    size_t bs = sum_block;
+    if(pool && !deterministic) bs = std::max<size_t>(1, (vn + pool->get_thread_count() - 1) / pool->get_thread_count());
+    size_t bc = (vn + bs - 1) / bs;
+    std::vector<float> part(bc, 0.0f);
+    auto block = [&](size_t bi){
+        float s{};
+        for(size_t i = bi*bs; i < std::min(vn, (bi + 1)*bs); ++i) s += v(i)*v(i);
+        part[bi] = s;
+    };
+    if(pool) pool->parallel_for(bc, block);
+    else for(size_t bi = 0; bi < bc; ++bi) block(bi);
+    float res{};
+    for(float s : part) res += s;
+    return res;
+}
@@ -5,22 +5,56 @@
 
 #include <string>
 #include "matrix.h"
+#include "quantized_matrix.h"
+#include "h_matrix.h"
+
+class Thread_pool;
+
+/* 
+Form-Factor storage the solver runs on: float, 16 or 8 bit quantized, or H-matrix.
+ */
+enum class ff_format : int {f32=0,q16=1,q8=2,hmat=3};
 
 
 /* 
 class Stimuli
 referenced by: class Radiosity
 Solver for K B = E 
+solve runs to convergence, step runs one residual check + sweep so callers can interleave 
+stimuli and watch B converge. step returns true once the residual is below tolerance.
+After every step residual holds E - K B for the B the step started from, and max_delta the largest 
+change of B made by its sweep (0 once converged).
+With a pool (set_pool) residual rows are computed in parallel, each row in the serial order, and the residual 
+norm is summed in fixed blocks added in block order, so B and every residual are bit-identical for any thread 
+count. Non-deterministic pools sum one block per thread instead. Gauss-Seidel sweeps stay serial.
  */
 
 class Stimuli{
     public:
-    Stimuli(int fc, float fw, int hps, const Matrix<float,2>& f, float e_s, float f0_s, float f1_s, float f2_s, float f3_s, float f4_s);
+    Stimuli(size_t n);
+    void set_stimuli(int fc, int hps, float e_s, float f0_s, float f1_s, float f2_s, float f3_s, float f4_s);
+    void solve(const Matrix<float,2>& f);
+    void build_k(const Matrix<float,2>& f);
+    bool step();
+    bool step(const Quantized_matrix<uint16_t>& f);
+    bool step(const Quantized_matrix<uint8_t>& f);
+    bool step(const H_matrix& f);
+    float squared_residual(const Matrix<float,2>& f)const;
+    void set_pool(Thread_pool* p, bool d){pool = p; deterministic = d;}
     size_t n;
     Matrix<float,1> b;
     Matrix<float,1> residual;
-    Matrix<float,2> p;
+    float residual_norm;
+    float max_delta;
+    Matrix<float,1> p;
+    Matrix<float,1> e;
     Matrix<float,2> k;
+    private:
+    template<typename Q>
+        bool step_q(const Quantized_matrix<Q>& f);
+    float squared_norm(const Matrix<float,1>& v)const;
+    Thread_pool* pool;
+    bool deterministic;
 };
 
 #endif //STIMULI_H
@@ -0,0 +1,141 @@
+#include "thread_pool.h"
+
+/* 
+Thread_pool Constructor
+Description:
+Starts the worker threads.
+
+Parameters: 
+size_t tc: Thread count, 0 uses every hardware thread.
+
+Output: -
+ */
+Thread_pool::Thread_pool(size_t tc):
+queues{},
+threads{},
+m{},
+cv{},
+done_cv{},
+pending{0},
+generation{0},
+stop{false}
+{
+    if(tc == 0) tc = std::thread::hardware_concurrency();
+    if(tc == 0) tc = 1;
+    for(size_t i = 0; i < tc; ++i) queues.push_back(std::make_unique<Job_queue>());
+    for(size_t i = 0; i < tc; ++i) threads.emplace_back(&Thread_pool::worker, this, i);
+}
+
+/* 
+Thread_pool Destructor
+Description:
+Stops and joins the worker threads.
+
+Parameters: 
+
+Output: -
+ */
+Thread_pool::~Thread_pool(){
+    {
+        std::lock_guard<std::mutex> lk(m);
+        stop = true;
+    }
+    cv.notify_all();
+    for(auto& t:threads) t.join();
+}
+
+/* 
+void Thread_pool::parallel_for(size_t jc, const std::function<void(size_t)>& f)
+Description:
+Runs f(0) ... f(jc-1) on the workers and waits for all of them. 
+Worker i is dealt jobs [i*jc/tc, (i+1)*jc/tc), the rest is balanced by stealing.
+
+Parameters: 
+size_t jc: Job count.
+const std::function<void(size_t)>& f: Job, receives the job index.
+
+Output: -
+ */
+void Thread_pool::parallel_for(size_t jc, const std::function<void(size_t)>& f){
+    if(jc == 0) return;
+    size_t tc = threads.size();
+    {
+        std::lock_guard<std::mutex> lk(m);
+        pending = jc;
+        for(size_t i = 0; i < tc; ++i){
+            std::lock_guard<std::mutex> qlk(queues[i]->m);
+            for(size_t j = i*jc/tc; j < (i+1)*jc/tc; ++j) queues[i]->q.push_back({&f, j});
+        }
+        ++generation;
+    }
+    cv.notify_all();
+    std::unique_lock<std::mutex> lk(m);
+    done_cv.wait(lk, [this]{return pending == 0;});
+}
+
+/* 
+bool Thread_pool::pop(size_t wi, Job& j)
+Description:
+Takes the next job of worker wi, from its own deque first and stealing otherwise.
+
+Parameters: 
+size_t wi: Worker index.
+Job& j: Job taken.
+
+Output:
+bool: Whether a job was found.
+ */
+bool Thread_pool::pop(size_t wi, Job& j){
+    {
+        Job_queue& q = *queues[wi];
+        std::lock_guard<std::mutex> lk(q.m);
+        if(!q.q.empty())
+        {
+            j = q.q.back();
+            q.q.pop_back();
+            return true;
+        }
+    }
+    for(size_t i = 1; i < queues.size(); ++i){
+        Job_queue& q = *queues[(wi + i) % queues.size()];
+        std::lock_guard<std::mutex> lk(q.m);
+        if(!q.q.empty())
+        {
+            j = q.q.front();
+            q.q.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+/* 
+void Thread_pool::worker(size_t wi)
+Description:
+Worker loop, sleeps until a parallel_for deals jobs and runs them until none is left anywhere.
+
+Parameters: 
+size_t wi: Worker index.
+
+Output: -
+ */
+void Thread_pool::worker(size_t wi){
+    size_t seen = 0;
+    for(;;){
+        {
+            std::unique_lock<std::mutex> lk(m);
+            cv.wait(lk, [&]{return stop || generation != seen;});
+            if(stop) return;
+            seen = generation;
+        }
+        Job j{};
+        while(pop(wi, j)){
+            (*j.first)(j.second);
+            if(pending.fetch_sub(1) == 1)
+            {
+                std::lock_guard<std::mutex> lk(m);
+                done_cv.notify_all();
+            }
+        }
+    }
+}
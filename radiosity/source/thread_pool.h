@@ -0,0 +1,56 @@
+/* date = October 19th 2026 6:02 pm */
+
+/* 
+class Thread_pool
+referenced by: class Projector, class Radiosity
+Fixed set of worker threads running parallel_for jobs with work stealing.
+
+Jobs get dealt in contiguous runs, one deque per worker. A worker pops from the back of its 
+own deque and, once empty, steals from the front of the others, so uneven jobs 
+(e.g. tiles covering the emitter vs background) balance out by themselves. 
+parallel_for blocks until every job has run, it MUST NOT be called from within a job.
+ */
+
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+#include <memory>
+
+class Thread_pool{
+    public:
+    Thread_pool(size_t tc = 0);
+    ~Thread_pool();
+    
+    Thread_pool(const Thread_pool&)=delete;
+    Thread_pool& operator=(const Thread_pool&)=delete;
+    
+    void parallel_for(size_t jc, const std::function<void(size_t)>& f);
+    size_t get_thread_count()const{return threads.size();}
+    
+    private:
+    using Job = std::pair<const std::function<void(size_t)>*, size_t>;
+    struct Job_queue{
+        std::mutex m;
+        std::deque<Job> q;
+    };
+    void worker(size_t wi);
+    bool pop(size_t wi, Job& j);
+    
+    std::vector<std::unique_ptr<Job_queue>> queues;
+    std::vector<std::thread> threads;
+    std::mutex m;
+    std::condition_variable cv;
+    std::condition_variable done_cv;
+    std::atomic<size_t> pending;
+    size_t generation;
+    bool stop;
+};
+
+#endif //THREAD_POOL_H
@@ -0,0 +1,82 @@
+#include "tone_map.h"
+#include <cmath>
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define TONE_MAP_SSE2 1
+#include <emmintrin.h>
+#else
+#define TONE_MAP_SSE2 0
+#endif
+
+/* 
+LUT resolution over the Reinhard output range [0,1).
+ */
+static const int lut_size = 4096;
+
+/* 
+struct Srgb_lut
+Linear [0,1] to 8 bit sRGB, built once on first use.
+ */
+struct Srgb_lut{
+    Srgb_lut(){
+        for(int i = 0; i < lut_size; ++i){
+            float l = float(i) / float(lut_size - 1);
+            float s = l <= 0.0031308f ? 12.92f * l : 1.055f * std::pow(l, 1.0f / 2.4f) - 0.055f;
+            v[i] = static_cast<unsigned char>(std::min(255.0f, s * 255.0f + 0.5f));
+        }
+    }
+    unsigned char v[lut_size];
+};
+
+static const Srgb_lut& get_lut(){
+    static const Srgb_lut lut{};
+    return lut;
+}
+
+/* 
+static int lut_index(float x, float e)
+Description:
+Scalar exposure + Reinhard, returns the LUT index.
+ */
+static int lut_index(float x, float e){
+    float l = std::max(0.0f, x * e);
+    return static_cast<int>(std::min(1.0f, l / (1.0f + l)) * float(lut_size - 1) + 0.5f);
+}
+
+/* 
+void tone_map(const float* in, unsigned char* out, size_t c, float exposure)
+Description:
+Tone maps c channels of linear radiance into 8 bit sRGB.
+
+Parameters: 
+const float* in: Linear radiance channels, e.g. RGB RGB ...
+unsigned char* out: Output channels, c bytes.
+size_t c: Channel count.
+float exposure: Radiance scale applied before Reinhard.
+
+Output: -
+ */
+void tone_map(const float* in, unsigned char* out, size_t c, float exposure){
+    const unsigned char* lut = get_lut().v;
+    size_t i = 0;
+#if TONE_MAP_SSE2
+    const __m128 e = _mm_set1_ps(exposure);
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 scale = _mm_set1_ps(float(lut_size - 1));
+    const __m128 half = _mm_set1_ps(0.5f);
+    alignas(16) int idx[4];
+    for(; i + 4 <= c; i += 4){
+        __m128 l = _mm_max_ps(zero, _mm_mul_ps(_mm_loadu_ps(in + i), e));
+        // NOTE(Alex): min with 1 as second operand also maps inf/inf NaNs back into the LUT
+        __m128 m = _mm_min_ps(_mm_div_ps(l, _mm_add_ps(one, l)), one);
+        _mm_store_si128(reinterpret_cast<__m128i*>(idx), _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(m, scale), half)));
+        out[i + 0] = lut[idx[0]];
+        out[i + 1] = lut[idx[1]];
+        out[i + 2] = lut[idx[2]];
+        out[i + 3] = lut[idx[3]];
+    }
+#endif
+    for(; i < c; ++i) out[i] = lut[lut_index(in[i], exposure)];
+}
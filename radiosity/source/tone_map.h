@@ -0,0 +1,24 @@
+/* date = October 19th 2026 8:31 pm */
+
+/* 
+tone_map
+referenced by: class Canvas
+Maps HDR radiance onto 8 bit sRGB:
+-Exposure scales radiance: L = e * x
+-Reinhard operator compresses it into [0,1): L / (1 + L)
+-An sRGB transfer curve LUT encodes it into [0-255]
+
+The first two steps run 4 channels at a time with SSE2 when available.
+
+References:
+E. Reinhard, M. Stark, P. Shirley, J. Ferwerda. Photographic tone reproduction for digital images. SIGGRAPH '02, pp. 267-276.
+ */
+
+#ifndef TONE_MAP_H
+#define TONE_MAP_H
+
+#include <cstddef>
+
+void tone_map(const float* in, unsigned char* out, size_t c, float exposure);
+
+#endif //TONE_MAP_H
@@ -0,0 +1,112 @@
+#include "trace.h"
+
+#if defined(RADIOSITY_TRACE)
+
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <fstream>
+#include <iostream>
+#include <cstdlib>
+
+/* 
+Events kept per thread, older ones are overwritten.
+ */
+static const size_t trace_capacity = size_t(1) << 16;
+
+struct Trace_buffer{
+    Trace_buffer():events(trace_capacity),written{0}{}
+    std::vector<Trace_event> events;
+    std::atomic<uint64_t> written;
+};
+
+struct Trace_state{
+    std::mutex m;
+    std::vector<std::unique_ptr<Trace_buffer>> buffers;
+    std::chrono::steady_clock::time_point t0{std::chrono::steady_clock::now()};
+};
+
+static Trace_state& get_state()
+{
+    // NOTE(Alex): Never destroyed, the dump runs from atexit
+    static Trace_state* s = new Trace_state{};
+    return *s;
+}
+
+/* 
+void dump_trace()
+Description:
+Writes every buffer into "trace.json", thread ids are the order threads recorded their first event in.
+
+Parameters: 
+
+Output: -
+ */
+static void dump_trace()
+{
+    Trace_state& s = get_state();
+    std::lock_guard<std::mutex> l{s.m};
+    std::ofstream o{"trace.json"};
+    if(!o)
+    {
+        std::cout << "Unable to open file:trace.json" << std::endl;
+        return;
+    }
+    o << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    const char* sep = "\n";
+    for(size_t t = 0; t < s.buffers.size(); ++t){
+        const Trace_buffer& b = *s.buffers[t];
+        o << sep << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << t 
+            << ",\"args\":{\"name\":\"thread " << t << "\"}}";
+        sep = ",\n";
+        uint64_t w = b.written.load(std::memory_order_acquire);
+        uint64_t first = w > trace_capacity ? w - trace_capacity : 0;
+        for(uint64_t k = first; k < w; ++k){
+            const Trace_event& e = b.events[k % trace_capacity];
+            // NOTE(Alex): trace_event times are microseconds, fractions keep the nanoseconds
+            o << sep << "{\"name\":\"" << e.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << t 
+                << ",\"ts\":" << double(e.ts) / 1000.0 << ",\"dur\":" << double(e.dur) / 1000.0 << "}";
+        }
+    }
+    o << "\n]}\n";
+}
+
+/* 
+Trace_buffer* get_buffer()
+Description:
+Buffer of the calling thread, registered on first use.
+
+Parameters: 
+
+Output:
+Trace_buffer*: Buffer of the calling thread.
+ */
+static Trace_buffer* get_buffer()
+{
+    thread_local Trace_buffer* b = nullptr;
+    if(!b)
+    {
+        Trace_state& s = get_state();
+        std::lock_guard<std::mutex> l{s.m};
+        if(s.buffers.empty()) std::atexit(dump_trace);
+        s.buffers.push_back(std::make_unique<Trace_buffer>());
+        b = s.buffers.back().get();
+    }
+    return b;
+}
+
+int64_t trace_now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - get_state().t0).count();
+}
+
+void trace_record(const char* name, int64_t ts, int64_t dur)
+{
+    Trace_buffer* b = get_buffer();
+    uint64_t w = b->written.load(std::memory_order_relaxed);
+    b->events[w % trace_capacity] = Trace_event{name, ts, dur};
+    b->written.store(w + 1, std::memory_order_release);
+}
+
+#endif //RADIOSITY_TRACE
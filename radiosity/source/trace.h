@@ -0,0 +1,54 @@
+/* date = October 20th 2026 9:05 pm */
+
+/* 
+Trace
+referenced by: class Quad_manager, class Radiosity, class Projector, class Canvas, class Solution_cache, class Preview_renderer
+Timeline of scoped events written at exit as Chrome trace JSON ("trace.json", trace_event format), 
+to be loaded in chrome://tracing or Perfetto to see load balance and idle time per thread.
+
+Every thread records into its own ring buffer of trace_capacity events, so recording never takes a lock: 
+the thread is the only writer and the buffer is only read at exit, when workers have been joined. 
+Full buffers overwrite their oldest events. Buffers are registered once per thread and outlive it.
+
+Only built with RADIOSITY_TRACE defined (the debug and bin\instrumented builds), otherwise TRACE_SCOPE expands to nothing.
+
+TRACE_SCOPE(name): Records the enclosing scope as one complete event, name MUST be a string literal.
+ */
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#if defined(RADIOSITY_TRACE)
+
+#include <cstdint>
+#include <chrono>
+
+struct Trace_event{
+    const char* name;
+    int64_t ts;
+    int64_t dur;
+};
+
+int64_t trace_now();
+void trace_record(const char* name, int64_t ts, int64_t dur);
+
+class Trace_scope{
+    public:
+    Trace_scope(const char* name_):name{name_},ts{trace_now()}{}
+    ~Trace_scope(){trace_record(name, ts, trace_now() - ts);}
+    private:
+    const char* name;
+    int64_t ts;
+};
+
+#define TRACE_CAT_(a, b) a##b
+#define TRACE_CAT(a, b) TRACE_CAT_(a, b)
+#define TRACE_SCOPE(name) Trace_scope TRACE_CAT(trace_scope_, __LINE__){name}
+
+#else
+
+#define TRACE_SCOPE(name)
+
+#endif //RADIOSITY_TRACE
+
+#endif //TRACE_H
@@ -3,10 +3,56 @@
 #ifndef UTILITY_H
 #define UTILITY_H
 
+#include <cstdint>
+#include <cstddef>
+#include <chrono>
+#include <iostream>
+
 template<typename T = float> 
 inline T Lerp(const T &lo, const T &hi, const float t) 
 { 
     return lo * (1 - t) + hi * t; 
 }
 
+/* 
+FNV-1a 64 bit hash, chain calls through h to hash several buffers.
+ */
+inline uint64_t Fnv1a(const void* d, size_t s, uint64_t h = 14695981039346656037ull)
+{
+    const unsigned char* p = static_cast<const unsigned char*>(d);
+    for(size_t i = 0; i < s; ++i){
+        h ^= p[i];
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+/* 
+xorshift64 step, uniform float in [0,1). The state MUST NOT be 0.
+ */
+inline float Xorshift_float(uint64_t& s)
+{
+    s ^= s << 13;
+    s ^= s >> 7;
+    s ^= s << 17;
+    return static_cast<float>(s >> 40) / 16777216.0f;
+}
+
+/* 
+Times the enclosing scope, on exit stores the elapsed seconds in s and prints "<name>: <s> s".
+ */
+class Phase_timer{
+    public:
+    Phase_timer(const char* name_, double& s_):name{name_},s{s_},t0{std::chrono::steady_clock::now()}{}
+    ~Phase_timer()
+    {
+        s = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+        std::cout << name << ": " << s << " s" << std::endl;
+    }
+    private:
+    const char* name;
+    double& s;
+    std::chrono::steady_clock::time_point t0;
+};
+
 #endif //UTILITY_H
@@ -0,0 +1,177 @@
+/*
+Convergence Summary
+Compares the convergence curves written by main --convergence-log (see source/convergence_log.h).
+Every input file is one run, its runs are named "<file>:<mode>". Per run it prints the sweeps and
+seconds to converge, the mean residual reduction per sweep and the first sweep reaching each residual
+decade, taking the worst channel of each sweep:
+
+run sweeps seconds rate final_residual final_balance | sweeps to residual 1e3 1e2 1e1 1e0
+
+With --curves the worst channel residual of every run is also written side by side, one row per sweep,
+ready to plot.
+
+usage: convergence_summary <log.csv> [<log.csv> ...] [--curves curves.csv]
+ */
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+
+struct Record{
+    size_t sweep;
+    double elapsed_s;
+    float residual;
+    float balance;
+};
+
+struct Run{
+    std::string name;
+    std::vector<Record> records;
+};
+
+static const float decades[]{1e3f, 1e2f, 1e1f, 1e0f};
+
+/*
+static bool read_log(const std::string& path, std::vector<Run>& runs)
+Description:
+Reads a convergence log, records are grouped into one run per mode in the order they appear.
+
+Parameters:
+const std::string& path: CSV written by Convergence_log.
+std::vector<Run>& runs: Runs are appended here.
+
+Output:
+bool: false when the file can not be read or holds no records.
+ */
+static bool read_log(const std::string& path, std::vector<Run>& runs)
+{
+    std::ifstream in{path};
+    if(!in) return false;
+    std::string line;
+    std::getline(in, line);
+    size_t first = runs.size();
+    while(std::getline(in, line)){
+        std::stringstream ss{line};
+        std::vector<std::string> f;
+        for(std::string x; std::getline(ss, x, ',');) f.push_back(x);
+        if(f.size() != 12) continue;
+        std::string name = path + ":" + f[0];
+        if(runs.size() == first || runs.back().name != name) runs.push_back({name, {}});
+        Record r{};
+        r.sweep = std::stoul(f[1]);
+        r.elapsed_s = std::stod(f[2]);
+        r.residual = std::max({std::stof(f[3]), std::stof(f[4]), std::stof(f[5])});
+        float b[3]{std::stof(f[9]), std::stof(f[10]), std::stof(f[11])};
+        r.balance = *std::max_element(b, b + 3, [](float x, float y){return std::abs(x) < std::abs(y);});
+        runs.back().records.push_back(r);
+    }
+    return runs.size() > first;
+}
+
+/*
+static void print_summary(const Run& r)
+Description:
+Prints the summary line of one run. The rate is the geometric mean residual ratio between
+consecutive sweeps, the smaller the faster the solver converges.
+
+Parameters:
+const Run& r: Run with at least one record.
+
+Output: -
+ */
+static void print_summary(const Run& r)
+{
+    const Record& first = r.records.front();
+    const Record& last = r.records.back();
+    double rate = 0.0;
+    if(last.sweep > first.sweep && first.residual > 0.0f && last.residual > 0.0f)
+    {
+        rate = std::pow(double(last.residual) / double(first.residual), 1.0 / double(last.sweep - first.sweep));
+    }
+    std::cout << r.name << " " << last.sweep << " " << last.elapsed_s << " " << rate
+        << " " << last.residual << " " << last.balance << " |";
+    for(float d : decades){
+        auto it = std::find_if(r.records.begin(), r.records.end(), [d](const Record& x){return x.residual < d;});
+        if(it == r.records.end()) std::cout << " -";
+        else std::cout << " " << it->sweep;
+    }
+    std::cout << std::endl;
+}
+
+/*
+static bool write_curves(const std::string& path, const std::vector<Run>& runs)
+Description:
+Writes the worst channel residual of every run per sweep, runs that already converged leave their cell empty.
+
+Parameters:
+const std::string& path: Output CSV.
+const std::vector<Run>& runs: Runs to compare.
+
+Output:
+bool: Whether the file was written.
+ */
+static bool write_curves(const std::string& path, const std::vector<Run>& runs)
+{
+    std::ofstream o{path};
+    if(!o) return false;
+    size_t sweeps = 0;
+    o << "sweep";
+    for(const Run& r : runs){
+        o << "," << r.name;
+        sweeps = std::max(sweeps, r.records.back().sweep);
+    }
+    o << "\n";
+    std::vector<size_t> at(runs.size(), 0);
+    for(size_t s = 0; s <= sweeps; ++s){
+        o << s;
+        for(size_t k = 0; k < runs.size(); ++k){
+            const std::vector<Record>& rec = runs[k].records;
+            while(at[k] < rec.size() && rec[at[k]].sweep < s) ++at[k];
+            o << ",";
+            if(at[k] < rec.size() && rec[at[k]].sweep == s) o << rec[at[k]].residual;
+        }
+        o << "\n";
+    }
+    return bool(o);
+}
+
+int main(int argc, char** argv)
+{
+    std::vector<std::string> logs;
+    std::string curves;
+    for(int i = 1; i < argc; ++i){
+        std::string a{argv[i]};
+        if(a == "--curves" && i + 1 < argc) curves = argv[++i];
+        else logs.push_back(a);
+    }
+    if(logs.empty())
+    {
+        std::cout << "usage: convergence_summary <log.csv> [<log.csv> ...] [--curves curves.csv]" << std::endl;
+        return 1;
+    }
+
+    std::vector<Run> runs;
+    for(const std::string& l : logs){
+        if(!read_log(l, runs))
+        {
+            std::cout << "Unable to read " << l << std::endl;
+            return 1;
+        }
+    }
+
+    std::cout << "run sweeps seconds rate final_residual final_balance | sweeps to residual";
+    for(float d : decades) std::cout << " " << d;
+    std::cout << std::endl;
+    for(const Run& r : runs) print_summary(r);
+
+    if(!curves.empty() && !write_curves(curves, runs))
+    {
+        std::cout << "Unable to write " << curves << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,418 @@
+/*
+Form-Factor Validation
+Measures how accurate each Form-Factor engine is against closed-form results, and what it costs.
+
+Two plates are built with the same Face setups the Cornell Box uses, so their Form-Factor between each
+other has a closed form (Cohen & Wallace, Radiosity and Realistic Image Synthesis, appendix C):
+
+parallel: Face_yz_x0 -> Face_yz_x5, directly opposed squares of side fw at distance fw.
+perpendicular: Face_xy_z0 -> Face_yz_x0, squares of side fw sharing an edge.
+
+The plate to plate Form-Factor of a numeric F is the area weighted mean over the elements i of plate a of
+sum F_ij over the elements j of plate b, (F 1_b)_i with equal element areas.
+Engines are the HemiCube (Element::get_ray + Element::calc_ff on the plates alone, one brute force
+closest hit per ray) and the solver's compressed copies of its F: q16, q8 (Quantized_matrix) and hmat
+(H_matrix). The time of a compressed engine includes the HemiCube it compresses.
+hemicube_delta casts the same rays but weights every hit pixel with the textbook delta Form-Factor of a
+unit HemiCube, da cos_i / (pi r^3), instead of Element::calc_ff. It tells discretization error (both
+engines) from weighting error (Element::calc_ff only).
+
+Every case runs for every hps (elements per plate side) and HemiCube resolution. A point is on the Pareto
+front of its case when no other point of the case is both as fast and as accurate and better at one of them.
+For each case, HemiCube engine and hps the smallest resolution within --tolerance relative error is reported,
+next to the error of the default hm_xc x hm_yc, the numbers to hold that default against.
+Outputs:
+
+<out>.csv: case,engine,hps,hemicube,seconds,ff,analytic,rel_error,pareto
+
+usage: ff_validation [--hps 1,2,4,8] [--hemicube 10,25,50,100,200] [--tolerance 0.01] [--out ff_validation]
+ */
+
+#define _USE_MATH_DEFINES
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <functional>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cfloat>
+#include <cstdlib>
+
+#include "face.h"
+#include "quad.h"
+#include "matrix.h"
+#include "quantized_matrix.h"
+#include "h_matrix.h"
+
+struct Validation_point{
+    std::string plates;
+    std::string engine;
+    int hps;
+    int hc;
+    double s;
+    double ff;
+    double analytic;
+    double rel_error;
+    bool pareto;
+};
+
+struct Validation_config{
+    std::vector<int> hps;
+    std::vector<int> hc;
+    double tolerance;
+    std::string out;
+};
+
+/*
+struct Plates
+Two Faces of hps x hps elements, a is the source of the Form-Factor and b the receiver.
+ */
+struct Plates{
+    std::vector<std::shared_ptr<Quad>> quads;
+    std::vector<Face_grid> grids;
+    std::vector<Vec3<float>> p;
+    Matrix<float,1> in_b;
+    size_t na;
+};
+
+static const float fw = 10.0f;
+
+/*
+static double ff_parallel(double a, double b, double c)
+Description:
+Form-Factor between two directly opposed parallel rectangles.
+
+Parameters:
+double a: Rectangle width.
+double b: Rectangle height.
+double c: Distance between them.
+
+Output:
+double: Form-Factor.
+ */
+static double ff_parallel(double a, double b, double c)
+{
+    double x = a / c;
+    double y = b / c;
+    double x1 = std::sqrt(1.0 + x*x);
+    double y1 = std::sqrt(1.0 + y*y);
+    return 2.0 / (M_PI*x*y) * (std::log(x1*y1 / std::sqrt(1.0 + x*x + y*y))
+                               + x*y1*std::atan(x / y1) + y*x1*std::atan(y / x1)
+                               - x*std::atan(x) - y*std::atan(y));
+}
+
+/*
+static double ff_perpendicular(double w, double h, double l)
+Description:
+Form-Factor between two perpendicular rectangles sharing an edge.
+
+Parameters:
+double w: Width of the source rectangle, away from the common edge.
+double h: Height of the receiver rectangle, away from the common edge.
+double l: Length of the common edge.
+
+Output:
+double: Form-Factor.
+ */
+static double ff_perpendicular(double w, double h, double l)
+{
+    double W = w / l;
+    double H = h / l;
+    double w2 = W*W;
+    double h2 = H*H;
+    double s = std::sqrt(w2 + h2);
+    double l1 = (1.0 + w2)*(1.0 + h2) / (1.0 + w2 + h2);
+    double l2 = std::pow(w2*(1.0 + w2 + h2) / ((1.0 + w2)*(w2 + h2)), w2);
+    double l3 = std::pow(h2*(1.0 + w2 + h2) / ((1.0 + h2)*(w2 + h2)), h2);
+    return 1.0 / (M_PI*W) * (W*std::atan(1.0 / W) + H*std::atan(1.0 / H) - s*std::atan(1.0 / s)
+                             + 0.25*std::log(l1*l2*l3));
+}
+
+/*
+static Plates make_plates(bool parallel, int hps)
+Description:
+Builds the plates of one case, elements of a come first.
+
+Parameters:
+bool parallel: Parallel case, perpendicular otherwise.
+int hps: Elements per plate side.
+
+Output:
+Plates: Plates with their grids, element positions and the indicator vector of b.
+ */
+static Plates make_plates(bool parallel, int hps)
+{
+    Plates pl{};
+    ElemIndex ei = 0;
+    if(parallel)
+    {
+        Face_yz_x0 a{fw, hps, ei, pl.quads};
+        Face_yz_x5 b{fw, hps, ei, pl.quads};
+        pl.grids = {a.get_grid(), b.get_grid()};
+    }
+    else
+    {
+        Face_xy_z0 a{fw, hps, ei, pl.quads};
+        Face_yz_x0 b{fw, hps, ei, pl.quads};
+        pl.grids = {a.get_grid(), b.get_grid()};
+    }
+    size_t n = pl.quads.size();
+    pl.na = size_t(hps)*size_t(hps);
+    pl.p.resize(n);
+    pl.in_b = Matrix<float,1>(n);
+    for(const std::shared_ptr<Quad>& q : pl.quads) pl.p[q->get_index()] = q->get_p();
+    for(size_t j = pl.na; j < n; ++j) pl.in_b(j) = 1.0f;
+    return pl;
+}
+
+/*
+static void calc_ff(Plates& pl, int hc, bool delta, Matrix<float,2>& f)
+Description:
+HemiCube Form-Factors of the elements of plate a, the rows of plate b stay 0.
+
+Parameters:
+Plates& pl: Plates.
+int hc: HemiCube resolution.
+bool delta: Weight pixels with the textbook delta Form-Factor rather than Element::calc_ff.
+Matrix<float,2>& f: Form-Factor matrix, n x n and zeroed.
+
+Output: -
+ */
+static void calc_ff(Plates& pl, int hc, bool delta, Matrix<float,2>& f)
+{
+    float da = (2.0f / float(hc))*(2.0f / float(hc));
+    for(const std::shared_ptr<Quad>& e : pl.quads){
+        if(size_t(e->get_index()) >= pl.na) continue;
+        e->reset_hemicube(hc, hc);
+        for(Ray r{}; e->get_ray(r);){
+            Quad* hit = nullptr;
+            float t_max = FLT_MAX;
+            for(const std::shared_ptr<Quad>& q : pl.quads){
+                Ray x = r;
+                HitRec rec;
+                if(q.get() != e.get() && q->hit(x, 0.001f, t_max, rec))
+                {
+                    t_max = rec.t;
+                    hit = q.get();
+                }
+            }
+            if(!hit) continue;
+            if(delta)
+            {
+                // NOTE(Alex): Ray directions end on the unit HemiCube, cos of the pixel is 1 / r on every face
+                Vec3<float> d = r.get_direction();
+                float r2 = d.squared_norm();
+                f(e->get_index(), hit->get_index()) += dot(e->get_n(), d)*da / (float(M_PI)*r2*r2);
+                continue;
+            }
+            Element_ref j{};
+            j = *hit;
+            e->calc_ff(r, j, f);
+        }
+    }
+}
+
+/*
+static double plate_ff(const Plates& pl, const Matrix<float,1>& fb)
+Description:
+Plate to plate Form-Factor from F 1_b.
+
+Parameters:
+const Plates& pl: Plates.
+const Matrix<float,1>& fb: F times the indicator vector of b.
+
+Output:
+double: Mean of fb over the elements of a.
+ */
+static double plate_ff(const Plates& pl, const Matrix<float,1>& fb)
+{
+    double s = 0.0;
+    for(size_t i = 0; i < pl.na; ++i) s += fb(i);
+    return s / double(pl.na);
+}
+
+/*
+static void mark_pareto(std::vector<Validation_point>& pts)
+Description:
+Marks the points no other point of their case dominates in seconds and error.
+
+Parameters:
+std::vector<Validation_point>& pts: Points of every case.
+
+Output: -
+ */
+static void mark_pareto(std::vector<Validation_point>& pts)
+{
+    for(Validation_point& a : pts){
+        a.pareto = true;
+        for(const Validation_point& b : pts){
+            if(&a == &b || a.plates != b.plates) continue;
+            bool no_worse = b.s <= a.s && b.rel_error <= a.rel_error;
+            bool better = b.s < a.s || b.rel_error < a.rel_error;
+            if(no_worse && better)
+            {
+                a.pareto = false;
+                break;
+            }
+        }
+    }
+}
+
+/*
+static void validate_case(bool parallel, int hps, int hc, std::vector<Validation_point>& pts)
+Description:
+Runs every engine on one case, hps and HemiCube resolution.
+
+Parameters:
+bool parallel: Parallel case, perpendicular otherwise.
+int hps: Elements per plate side.
+int hc: HemiCube resolution.
+std::vector<Validation_point>& pts: One point per engine is appended here.
+
+Output: -
+ */
+static void validate_case(bool parallel, int hps, int hc, std::vector<Validation_point>& pts)
+{
+    std::string name = parallel ? "parallel" : "perpendicular";
+    double analytic = parallel ? ff_parallel(fw, fw, fw) : ff_perpendicular(fw, fw, fw);
+    Plates pl = make_plates(parallel, hps);
+    size_t n = pl.quads.size();
+
+    auto add = [&](const char* engine, double s, const Matrix<float,1>& fb){
+        double ff = plate_ff(pl, fb);
+        double e = std::abs(ff - analytic) / analytic;
+        pts.push_back({name, engine, hps, hc, s, ff, analytic, e, false});
+        std::cout << name << " " << engine << " hps " << hps << " hemicube " << hc << ": F " << ff
+            << " (analytic " << analytic << "), error " << e << ", " << s << " s" << std::endl;
+    };
+    auto seconds = [](const std::function<void()>& f){
+        auto t0 = std::chrono::steady_clock::now();
+        f();
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    };
+
+    Matrix<float,2> f(n, n);
+    double hc_s = seconds([&]{calc_ff(pl, hc, false, f);});
+    add("hemicube", hc_s, mult_m(f, pl.in_b));
+
+    std::unique_ptr<Quantized_matrix<uint16_t>> q16;
+    double q16_s = seconds([&]{q16 = std::make_unique<Quantized_matrix<uint16_t>>(f);});
+    add("q16", hc_s + q16_s, mult_m(*q16, pl.in_b));
+
+    std::unique_ptr<Quantized_matrix<uint8_t>> q8;
+    double q8_s = seconds([&]{q8 = std::make_unique<Quantized_matrix<uint8_t>>(f);});
+    add("q8", hc_s + q8_s, mult_m(*q8, pl.in_b));
+
+    std::unique_ptr<H_matrix> hf;
+    double h_s = seconds([&]{hf = std::make_unique<H_matrix>(f, pl.grids, pl.p);});
+    add("hmat", hc_s + h_s, mult_m(*hf, pl.in_b));
+
+    Matrix<float,2> fd(n, n);
+    double d_s = seconds([&]{calc_ff(pl, hc, true, fd);});
+    add("hemicube_delta", d_s, mult_m(fd, pl.in_b));
+}
+
+/*
+static void report_hemicube(const Validation_config& cfg, const std::vector<Validation_point>& pts)
+Description:
+Prints, for every case, HemiCube engine and hps, the smallest resolution within tolerance of the analytic
+Form-Factor and the error at the default hm_xc x hm_yc when it was tested.
+
+Parameters:
+const Validation_config& cfg: Resolutions swept and tolerance.
+const std::vector<Validation_point>& pts: Points of every case.
+
+Output: -
+ */
+static void report_hemicube(const Validation_config& cfg, const std::vector<Validation_point>& pts)
+{
+    for(const char* plates : {"parallel", "perpendicular"}){
+        for(const char* engine : {"hemicube", "hemicube_delta"}){
+            for(int hps : cfg.hps){
+                int first = 0;
+                double def_e = -1.0;
+                for(const Validation_point& p : pts){
+                    if(p.plates != plates || p.hps != hps || p.engine != engine) continue;
+                    if(p.rel_error <= cfg.tolerance && (!first || p.hc < first)) first = p.hc;
+                    if(p.hc == hm_xc) def_e = p.rel_error;
+                }
+                std::cout << plates << " " << engine << " hps " << hps << ": ";
+                if(first) std::cout << "within " << cfg.tolerance << " from hemicube " << first;
+                else std::cout << "never within " << cfg.tolerance;
+                if(def_e >= 0.0) std::cout << ", default " << hm_xc << " error " << def_e;
+                std::cout << std::endl;
+            }
+        }
+    }
+}
+
+static std::vector<int> parse_list(const std::string& s)
+{
+    std::vector<int> l;
+    std::stringstream ss{s};
+    for(std::string x; std::getline(ss, x, ',');) l.push_back(std::atoi(x.c_str()));
+    return l;
+}
+
+static bool write_points(const std::string& path, const std::vector<Validation_point>& pts)
+{
+    std::ofstream o{path};
+    if(!o) return false;
+    o.precision(9);
+    o << "case,engine,hps,hemicube,seconds,ff,analytic,rel_error,pareto\n";
+    for(const Validation_point& p : pts){
+        o << p.plates << "," << p.engine << "," << p.hps << "," << p.hc << "," << p.s << "," << p.ff
+            << "," << p.analytic << "," << p.rel_error << "," << (p.pareto ? 1 : 0) << "\n";
+    }
+    return bool(o);
+}
+
+int main(int argc, char** argv)
+{
+    Validation_config cfg{{1,2,4,8}, {10,25,50,100,200}, 0.01, "ff_validation"};
+    for(int i = 1; i < argc; ++i){
+        std::string a{argv[i]};
+        bool has_value = i + 1 < argc;
+        if(a == "--hps" && has_value) cfg.hps = parse_list(argv[++i]);
+        else if(a == "--hemicube" && has_value) cfg.hc = parse_list(argv[++i]);
+        else if(a == "--tolerance" && has_value) cfg.tolerance = std::atof(argv[++i]);
+        else if(a == "--out" && has_value) cfg.out = argv[++i];
+        else
+        {
+            std::cout << "usage: ff_validation [--hps 1,2,4,8] [--hemicube 10,25,50,100,200] [--tolerance 0.01] [--out ff_validation]" << std::endl;
+            return 1;
+        }
+    }
+    bool valid = !cfg.hps.empty() && !cfg.hc.empty() && cfg.tolerance > 0.0;
+    for(int h : cfg.hps) valid = valid && h > 0;
+    for(int h : cfg.hc) valid = valid && h > 1;
+    if(!valid)
+    {
+        std::cout << "hps and tolerance must be positive and hemicube above 1" << std::endl;
+        return 1;
+    }
+
+    std::vector<Validation_point> pts;
+    for(bool parallel : {true, false}){
+        for(int hps : cfg.hps){
+            for(int hc : cfg.hc) validate_case(parallel, hps, hc, pts);
+        }
+    }
+    mark_pareto(pts);
+
+    std::cout << "Pareto front (case engine hps hemicube seconds error):" << std::endl;
+    for(const Validation_point& p : pts){
+        if(p.pareto) std::cout << " " << p.plates << " " << p.engine << " " << p.hps << " " << p.hc << " " << p.s << " " << p.rel_error << std::endl;
+    }
+    report_hemicube(cfg, pts);
+
+    if(!write_points(cfg.out + ".csv", pts))
+    {
+        std::cout << "Unable to write " << cfg.out << ".csv" << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,303 @@
+/*
+Regression
+Runs the reference scene (Cornell Box, hps 10, HemiCube 100 x 100, float F) and compares its results and
+phase timings against the goldens in out/data, exits with 1 when anything regressed:
+
+- F0_matrix.ppm, B_*_s_matrix.ppm and f_*.ppm: the debug images of F, B and the Face vertex colors,
+  per pixel in 0..255 levels. K, P and Residual images are dumps of solver internals and are not compared.
+- regression_b.txt: B of every stimuli in full float precision, error relative to the largest golden B.
+- regression_<view>.ppm: the ortho and perspective renders at --size, per pixel in 0..255 levels.
+- regression_budget.txt: seconds of every phase, a phase fails when it takes more than --slack percent
+  over its budget. Budgets are machine specific, record them with --update on the machine that checks them,
+  without the file timings are not checked.
+
+Images fail on a maximum or a mean absolute difference over their tolerance. --update writes the results
+of this run as the new goldens instead of comparing. Outputs of the run land in the current directory,
+so run it from a scratch directory (bin/tools by default, where --golden points at out/data).
+--threads runs F, the residuals and the renders on that many threads (0, the default, on every hardware thread), 
+the deterministic mode keeps every result bit-identical to a single threaded run, so the goldens hold for any thread count.
+
+usage: regression [--golden ../../out/data] [--slack 20] [--size 128] [--threads 0] [--update]
+ */
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+#include "space.h"
+#include "projector.h"
+#include "camera.h"
+
+struct Image{
+    int w;
+    int h;
+    std::vector<int> px;
+};
+
+struct Image_check{
+    std::string name;
+    int max_diff;
+    float mean_diff;
+};
+
+struct Regression_config{
+    std::string golden;
+    float slack;
+    int size;
+    int threads;
+    bool update;
+};
+
+static const float fw = 10.0f;
+static const int hps = 10;
+static const char* phase_names[]{"mesh", "form_factors", "solve", "render"};
+// NOTE(Alex): Phases faster than this are timer noise, their budget is raised to it
+static const double min_budget_s = 0.05;
+// NOTE(Alex): B golden error, relative to the largest golden B
+static const float b_tolerance = 1e-4f;
+
+/*
+static bool read_ppm(const std::string& path, Image& img)
+Description:
+Reads an 8 bit P3 or P6 image.
+
+Parameters:
+const std::string& path: PPM file.
+Image& img: Image read, 3 ints per pixel.
+
+Output:
+bool: Whether the file was read.
+ */
+static bool read_ppm(const std::string& path, Image& img)
+{
+    std::ifstream in{path, std::ios::binary};
+    if(!in) return false;
+    std::string magic;
+    int maxval = 0;
+    in >> magic >> img.w >> img.h >> maxval;
+    if((magic != "P3" && magic != "P6") || img.w <= 0 || img.h <= 0 || maxval != 255) return false;
+    img.px.assign(size_t(img.w)*size_t(img.h)*3, 0);
+    if(magic == "P3")
+    {
+        for(int& v : img.px) in >> v;
+    }
+    else
+    {
+        in.get();
+        std::vector<unsigned char> raw(img.px.size());
+        in.read(reinterpret_cast<char*>(raw.data()), std::streamsize(raw.size()));
+        std::copy(raw.begin(), raw.end(), img.px.begin());
+    }
+    return bool(in);
+}
+
+static bool copy_file(const std::string& from, const std::string& to)
+{
+    std::ifstream in{from, std::ios::binary};
+    std::ofstream o{to, std::ios::binary};
+    if(!in || !o) return false;
+    o << in.rdbuf();
+    return bool(o);
+}
+
+/*
+static bool check_image(const Image_check& c, const Regression_config& cfg)
+Description:
+Compares an image of this run with its golden.
+
+Parameters:
+const Image_check& c: Image and its tolerances.
+const Regression_config& cfg: Golden directory.
+
+Output:
+bool: Whether the image is within tolerance.
+ */
+static bool check_image(const Image_check& c, const Regression_config& cfg)
+{
+    Image a{};
+    Image g{};
+    if(!read_ppm(c.name, a) || !read_ppm(cfg.golden + "/" + c.name, g))
+    {
+        std::cout << "FAIL " << c.name << ": missing or unreadable" << std::endl;
+        return false;
+    }
+    if(a.w != g.w || a.h != g.h)
+    {
+        std::cout << "FAIL " << c.name << ": " << a.w << "x" << a.h << ", golden " << g.w << "x" << g.h << std::endl;
+        return false;
+    }
+    int max_d = 0;
+    double sum_d = 0.0;
+    for(size_t i = 0; i < a.px.size(); ++i){
+        int d = std::abs(a.px[i] - g.px[i]);
+        max_d = std::max(max_d, d);
+        sum_d += d;
+    }
+    float mean_d = float(sum_d / double(a.px.size()));
+    bool pass = max_d <= c.max_diff && mean_d <= c.mean_diff;
+    std::cout << (pass ? "PASS " : "FAIL ") << c.name << ": max " << max_d << " (" << c.max_diff
+        << "), mean " << mean_d << " (" << c.mean_diff << ")" << std::endl;
+    return pass;
+}
+
+/*
+static bool check_b(const Space& space, const Regression_config& cfg)
+Description:
+Compares B of the three stimuli with the float golden, or writes it with --update.
+Golden layout: element count, then one "r g b" line per element.
+
+Parameters:
+const Space& space: Solved space.
+const Regression_config& cfg: Golden directory.
+
+Output:
+bool: Whether B is within tolerance.
+ */
+static bool check_b(const Space& space, const Regression_config& cfg)
+{
+    std::string path = cfg.golden + "/regression_b.txt";
+    size_t n = space.get_b(0).get_extent();
+    if(cfg.update)
+    {
+        std::ofstream o{path};
+        o.precision(9);
+        o << n << "\n";
+        for(size_t i = 0; i < n; ++i) o << space.get_b(0)(i) << " " << space.get_b(1)(i) << " " << space.get_b(2)(i) << "\n";
+        return bool(o);
+    }
+    std::ifstream in{path};
+    size_t gn = 0;
+    if(!(in >> gn) || gn != n)
+    {
+        std::cout << "FAIL regression_b.txt: missing or not " << n << " elements" << std::endl;
+        return false;
+    }
+    float max_g = 0.0f;
+    float max_d = 0.0f;
+    for(size_t i = 0; i < n; ++i){
+        for(int c = 0; c < 3; ++c){
+            float g = 0.0f;
+            in >> g;
+            max_g = std::max(max_g, std::abs(g));
+            max_d = std::max(max_d, std::abs(space.get_b(c)(i) - g));
+        }
+    }
+    float rel = max_g > 0.0f ? max_d / max_g : max_d;
+    bool pass = bool(in) && rel <= b_tolerance;
+    std::cout << (pass ? "PASS " : "FAIL ") << "regression_b.txt: relative error " << rel << " (" << b_tolerance << ")" << std::endl;
+    return pass;
+}
+
+/*
+static bool check_budget(const Space& space, const Regression_config& cfg)
+Description:
+Compares the seconds of every phase with its budget, or writes the budgets with --update.
+
+Parameters:
+const Space& space: Space after render.
+const Regression_config& cfg: Golden directory and slack.
+
+Output:
+bool: Whether every phase is within budget.
+ */
+static bool check_budget(const Space& space, const Regression_config& cfg)
+{
+    std::string path = cfg.golden + "/regression_budget.txt";
+    if(cfg.update)
+    {
+        std::ofstream o{path};
+        for(int i = 0; i < 4; ++i) o << phase_names[i] << " " << space.get_phase_seconds(static_cast<solver_phase>(i)) << "\n";
+        return bool(o);
+    }
+    std::ifstream in{path};
+    if(!in)
+    {
+        std::cout << "SKIP regression_budget.txt: no budgets recorded on this machine, see --update" << std::endl;
+        return true;
+    }
+    bool pass = true;
+    std::string name;
+    double budget = 0.0;
+    while(in >> name >> budget){
+        int i = 0;
+        while(i < 4 && name != phase_names[i]) ++i;
+        if(i == 4) continue;
+        double s = space.get_phase_seconds(static_cast<solver_phase>(i));
+        double limit = std::max(budget, min_budget_s)*(1.0 + cfg.slack / 100.0);
+        bool ok = s <= limit;
+        std::cout << (ok ? "PASS " : "FAIL ") << name << ": " << s << " s (budget " << budget << " s, limit " << limit << " s)" << std::endl;
+        pass = pass && ok;
+    }
+    return pass;
+}
+
+int main(int argc, char** argv)
+{
+    Regression_config cfg{"../../out/data", 20.0f, 128, 0, false};
+    for(int i = 1; i < argc; ++i){
+        std::string a{argv[i]};
+        bool has_value = i + 1 < argc;
+        if(a == "--golden" && has_value) cfg.golden = argv[++i];
+        else if(a == "--slack" && has_value) cfg.slack = float(std::atof(argv[++i]));
+        else if(a == "--size" && has_value) cfg.size = std::atoi(argv[++i]);
+        else if(a == "--threads" && has_value) cfg.threads = std::atoi(argv[++i]);
+        else if(a == "--update") cfg.update = true;
+        else
+        {
+            std::cout << "usage: regression [--golden ../../out/data] [--slack 20] [--size 128] [--threads 0] [--update]" << std::endl;
+            return 1;
+        }
+    }
+    if(cfg.size < 1 || cfg.threads < 0 || cfg.slack < 0.0f)
+    {
+        std::cout << "size must be positive, threads and slack not negative" << std::endl;
+        return 1;
+    }
+
+    // NOTE(Alex): No Solution_cache, every phase runs and is timed in full
+    Space space{fw, hps};
+    space.set_persistence(false);
+    space.set_threads(size_t(cfg.threads));
+    std::vector<Camera> cams = get_ortho_cameras(fw, fw);
+    cams.push_back(get_persp_camera(fw, fw));
+    for(Camera& c : cams) c.name = "regression_" + c.name;
+    Projector p{size_t(cfg.threads)};
+    if(!space.render(p, cams, cfg.size, cfg.size)) return 1;
+    space.debug_print();
+
+    std::vector<Image_check> images{
+        {"F0_matrix.ppm", 1, 0.001f},
+        {"B_r_s_matrix.ppm", 1, 0.01f},
+        {"B_g_s_matrix.ppm", 1, 0.01f},
+        {"B_b_s_matrix.ppm", 1, 0.01f},
+        {"f_xy_z0.ppm", 1, 0.05f},
+        {"f_yz_x0.ppm", 1, 0.05f},
+        {"f_xz_y0.ppm", 1, 0.05f},
+        {"f_yz_x5.ppm", 1, 0.05f},
+        {"f_xz_y5.ppm", 1, 0.05f},
+        {"f_e.ppm", 1, 0.05f}};
+    // NOTE(Alex): Renders shade with interpolated vertex colors, a small change of B moves edge pixels by a few levels
+    for(const Camera& c : cams) images.push_back({c.name + ".ppm", 8, 0.25f});
+
+    bool pass = true;
+    for(const Image_check& c : images){
+        if(cfg.update)
+        {
+            bool ok = copy_file(c.name, cfg.golden + "/" + c.name);
+            if(!ok) std::cout << "Unable to write " << cfg.golden << "/" << c.name << std::endl;
+            pass = pass && ok;
+        }
+        else pass = check_image(c, cfg) && pass;
+    }
+    pass = check_b(space, cfg) && pass;
+    pass = check_budget(space, cfg) && pass;
+
+    if(cfg.update) std::cout << (pass ? "Goldens updated in " : "Unable to update goldens in ") << cfg.golden << std::endl;
+    else std::cout << (pass ? "Regression passed" : "Regression FAILED") << std::endl;
+    return pass ? 0 : 1;
+}
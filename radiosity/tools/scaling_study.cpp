@@ -0,0 +1,270 @@
+/*
+Scaling Study
+Runs the whole Radiosity pipeline (mesh, Form-Factors, solve, render) over a sweep of hps, HemiCube
+resolutions and thread counts, and records the seconds and peak RAM of every phase.
+The Solution_cache is off (Space::set_persistence), so every phase pays its full cost.
+
+Every thread count runs the pipeline from scratch on a fresh Space: F rows and residuals run on
+Space::set_threads of the row's thread count and the render on a Projector of the same count, meshing and
+Gauss-Seidel sweeps stay serial. Deterministic mode is on so every thread count solves the same B.
+Peak RAM is the sum of the per-category peaks of mem_accounting.h (matrices, elements, framebuffers)
+during the phase, memory-mapped matrices are not counted.
+
+Per phase an empirical complexity exponent k of t ~ n^k (n = element count) is fitted by least squares on
+log t against log n, for every HemiCube resolution and thread count with at least two hps. Outputs:
+
+<out>.csv: hps,n,hemicube,threads,mesh_s,form_factors_s,solve_s,render_s,mesh_peak_bytes,form_factors_peak_bytes,solve_peak_bytes,render_peak_bytes,
+mesh_speedup,form_factors_speedup,solve_speedup,render_speedup
+<out>_fit.csv: phase,hemicube,threads,exponent,r2
+
+Speedups are per phase, relative to the first thread count of the same hps and HemiCube.
+Above hps 57 F no longer fits in_core_bytes and goes to a scratch file, expect a knee there.
+
+usage: scaling_study [--hps 10,20,30] [--hemicube 100] [--threads 1,<hardware threads>] [--size 256] [--out scaling]
+ */
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <cmath>
+#include <cstdlib>
+#include <thread>
+
+#include "space.h"
+#include "projector.h"
+#include "camera.h"
+#include "mem_accounting.h"
+
+struct Scaling_row{
+    int hps;
+    size_t n;
+    int hc;
+    size_t threads;
+    double s[4];
+    size_t peak[4];
+    double speedup[4];
+};
+
+struct Scaling_config{
+    std::vector<int> hps;
+    std::vector<int> hc;
+    std::vector<int> threads;
+    int size;
+    std::string out;
+};
+
+static const float fw = 10.0f;
+static const char* phase_names[]{"mesh", "form_factors", "solve", "render"};
+
+static size_t ram_peak()
+{
+    return mem_get_peak(mem_category::matrix) + mem_get_peak(mem_category::elements) + mem_get_peak(mem_category::framebuffer);
+}
+
+/*
+static bool run_pipeline(int hps, int hc, const Scaling_config& cfg, std::vector<Scaling_row>& rows)
+Description:
+Meshes, computes F, solves and renders once per thread count, each on a fresh Space.
+
+Parameters:
+int hps: Elements per face side.
+int hc: HemiCube resolution.
+const Scaling_config& cfg: Thread counts and render size.
+std::vector<Scaling_row>& rows: One row per thread count is appended here.
+
+Output:
+bool: Whether every phase ran.
+ */
+static bool run_pipeline(int hps, int hc, const Scaling_config& cfg, std::vector<Scaling_row>& rows)
+{
+    std::vector<Camera> cams = get_ortho_cameras(fw, fw);
+    cams.push_back(get_persp_camera(fw, fw));
+    for(Camera& c : cams) c.name = "scaling_" + c.name;
+
+    size_t first = rows.size();
+    for(int tc : cfg.threads){
+        std::cout << "hps " << hps << " hemicube " << hc << " threads " << tc << std::endl;
+        Space space{fw, hps};
+        space.set_persistence(false);
+        space.set_deterministic(true);
+        space.set_hemicube(hc, hc);
+        space.set_threads(size_t(tc));
+        Projector p{size_t(tc)};
+
+        size_t peak[4];
+        mem_reset_peaks();
+        if(!space.mesh()) return false;
+        peak[0] = ram_peak();
+        mem_reset_peaks();
+        if(!space.compute_form_factors()) return false;
+        peak[1] = ram_peak();
+        mem_reset_peaks();
+        if(!space.solve()) return false;
+        peak[2] = ram_peak();
+        mem_reset_peaks();
+        if(!space.render(p, cams, cfg.size, cfg.size)) return false;
+        peak[3] = ram_peak();
+
+        Scaling_row r{hps, space.request_quads().size(), hc, p.get_thread_count(), {}, {peak[0], peak[1], peak[2], peak[3]}, {1.0, 1.0, 1.0, 1.0}};
+        for(int i = 0; i < 4; ++i){
+            r.s[i] = space.get_phase_seconds(static_cast<solver_phase>(i));
+            if(rows.size() > first && r.s[i] > 0.0) r.speedup[i] = rows[first].s[i] / r.s[i];
+        }
+        rows.push_back(r);
+    }
+    return true;
+}
+
+/*
+static bool fit_exponent(const std::vector<double>& x, const std::vector<double>& y, double& k, double& r2)
+Description:
+Least squares line y = a + k x, with its coefficient of determination.
+
+Parameters:
+const std::vector<double>& x: log n.
+const std::vector<double>& y: log t.
+double& k: Slope, the complexity exponent.
+double& r2: Coefficient of determination, 1 is a perfect power law.
+
+Output:
+bool: false with fewer than two distinct x.
+ */
+static bool fit_exponent(const std::vector<double>& x, const std::vector<double>& y, double& k, double& r2)
+{
+    size_t m = x.size();
+    if(m < 2) return false;
+    double mx = 0.0;
+    double my = 0.0;
+    for(size_t i = 0; i < m; ++i){
+        mx += x[i];
+        my += y[i];
+    }
+    mx /= double(m);
+    my /= double(m);
+    double sxx = 0.0;
+    double sxy = 0.0;
+    double syy = 0.0;
+    for(size_t i = 0; i < m; ++i){
+        sxx += (x[i] - mx)*(x[i] - mx);
+        sxy += (x[i] - mx)*(y[i] - my);
+        syy += (y[i] - my)*(y[i] - my);
+    }
+    if(sxx <= 0.0) return false;
+    k = sxy / sxx;
+    r2 = syy > 0.0 ? (sxy*sxy) / (sxx*syy) : 1.0;
+    return true;
+}
+
+static std::vector<int> parse_list(const std::string& s)
+{
+    std::vector<int> l;
+    std::stringstream ss{s};
+    for(std::string x; std::getline(ss, x, ',');) l.push_back(std::atoi(x.c_str()));
+    return l;
+}
+
+static bool write_rows(const std::string& path, const std::vector<Scaling_row>& rows)
+{
+    std::ofstream o{path};
+    if(!o) return false;
+    o << "hps,n,hemicube,threads,mesh_s,form_factors_s,solve_s,render_s,"
+        << "mesh_peak_bytes,form_factors_peak_bytes,solve_peak_bytes,render_peak_bytes,"
+        << "mesh_speedup,form_factors_speedup,solve_speedup,render_speedup\n";
+    for(const Scaling_row& r : rows){
+        o << r.hps << "," << r.n << "," << r.hc << "," << r.threads;
+        for(double s : r.s) o << "," << s;
+        for(size_t p : r.peak) o << "," << p;
+        for(double x : r.speedup) o << "," << x;
+        o << "\n";
+    }
+    return bool(o);
+}
+
+/*
+static bool write_fits(const std::string& path, const Scaling_config& cfg, const std::vector<Scaling_row>& rows)
+Description:
+Fits and prints the complexity exponent of every phase but meshing, per HemiCube resolution and thread count.
+
+Parameters:
+const std::string& path: Output CSV.
+const Scaling_config& cfg: HemiCube resolutions and thread counts swept.
+const std::vector<Scaling_row>& rows: Measurements.
+
+Output:
+bool: Whether the file was written.
+ */
+static bool write_fits(const std::string& path, const Scaling_config& cfg, const std::vector<Scaling_row>& rows)
+{
+    std::ofstream o{path};
+    if(!o) return false;
+    o << "phase,hemicube,threads,exponent,r2\n";
+    std::cout << "phase hemicube threads exponent r2" << std::endl;
+    for(int phase = 1; phase < 4; ++phase){
+        for(int hc : cfg.hc){
+            for(size_t ti = 0; ti < cfg.threads.size(); ++ti){
+                std::vector<double> x;
+                std::vector<double> y;
+                size_t tc = 0;
+                for(size_t i = 0; i < rows.size(); ++i){
+                    const Scaling_row& r = rows[i];
+                    // NOTE(Alex): Rows of one pipeline run come in cfg.threads order
+                    if(r.hc != hc || i % cfg.threads.size() != ti || r.s[phase] <= 0.0) continue;
+                    x.push_back(std::log(double(r.n)));
+                    y.push_back(std::log(r.s[phase]));
+                    tc = r.threads;
+                }
+                double k = 0.0;
+                double r2 = 0.0;
+                if(!fit_exponent(x, y, k, r2)) continue;
+                o << phase_names[phase] << "," << hc << "," << tc << "," << k << "," << r2 << "\n";
+                std::cout << phase_names[phase] << " " << hc << " " << tc << " " << k << " " << r2 << std::endl;
+            }
+        }
+    }
+    return bool(o);
+}
+
+int main(int argc, char** argv)
+{
+    int hw = int(std::thread::hardware_concurrency());
+    Scaling_config cfg{{10,20,30}, {100}, {1}, 256, "scaling"};
+    if(hw > 1) cfg.threads.push_back(hw);
+    for(int i = 1; i < argc; ++i){
+        std::string a{argv[i]};
+        bool has_value = i + 1 < argc;
+        if(a == "--hps" && has_value) cfg.hps = parse_list(argv[++i]);
+        else if(a == "--hemicube" && has_value) cfg.hc = parse_list(argv[++i]);
+        else if(a == "--threads" && has_value) cfg.threads = parse_list(argv[++i]);
+        else if(a == "--size" && has_value) cfg.size = std::atoi(argv[++i]);
+        else if(a == "--out" && has_value) cfg.out = argv[++i];
+        else
+        {
+            std::cout << "usage: scaling_study [--hps 10,20,30] [--hemicube 100] [--threads 1,<hardware threads>] [--size 256] [--out scaling]" << std::endl;
+            return 1;
+        }
+    }
+    bool valid = !cfg.hps.empty() && !cfg.hc.empty() && !cfg.threads.empty() && cfg.size > 0;
+    for(int h : cfg.hps) valid = valid && h > 0;
+    for(int h : cfg.hc) valid = valid && h > 1;
+    for(int t : cfg.threads) valid = valid && t > 0;
+    if(!valid)
+    {
+        std::cout << "hps, hemicube, threads and size must be positive" << std::endl;
+        return 1;
+    }
+
+    std::vector<Scaling_row> rows;
+    for(int hps : cfg.hps){
+        for(int hc : cfg.hc){
+            if(!run_pipeline(hps, hc, cfg, rows)) return 1;
+        }
+    }
+    if(!write_rows(cfg.out + ".csv", rows) || !write_fits(cfg.out + "_fit.csv", cfg, rows))
+    {
+        std::cout << "Unable to write " << cfg.out << std::endl;
+        return 1;
+    }
+    return 0;
+}